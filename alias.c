@@ -96,6 +96,10 @@ static bool print_alias(const wchar_t *name, const alias_T *alias, bool prefix);
 /* Hashtable mapping alias names (wide strings) to alias_T's. */
 hashtable_T aliases;
 
+/* Incremented whenever any alias is defined or removed so that parse trees
+ * made in advance can be checked if they are still valid. */
+unsigned long alias_generation = 0;
+
 
 /* Initializes the alias module. */
 void init_alias(void)
@@ -148,6 +152,7 @@ void define_alias(
     alias->value[namelen + valuelen + 1] = L'\0';
 
     vfreealias(ht_set(&aliases, alias->value + valuelen + 1, alias));
+    alias_generation++;
 }
 
 /* Removes the alias definition with the specified name if any.
@@ -159,6 +164,7 @@ bool remove_alias(const wchar_t *name)
 
     if (alias != NULL) {
 	free_alias(alias);
+	alias_generation++;
 	return true;
     } else {
 	return false;
@@ -169,6 +175,7 @@ bool remove_alias(const wchar_t *name)
 void remove_all_aliases(void)
 {
     ht_clear(&aliases, vfreealias);
+    alias_generation++;
 }
 
 /* Returns the value of the specified alias (or null if there is no such). */
@@ -470,7 +477,7 @@ int alias_builtin(int argc, void **argv)
     if (xoptind == argc) {
 	/* print all aliases */
 	kvpair_T *kvs = ht_tokvarray(&aliases);
-	qsort(kvs, aliases.count, sizeof *kvs, keywcscoll);
+	sort_by_wcscoll(kvs, aliases.count, sizeof *kvs, keywcs);
 	for (size_t i = 0; i < aliases.count; i++) {
 	    print_alias(kvs[i].key, kvs[i].value, prefix);
 	    if (yash_error_message_count > 0)
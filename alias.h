@@ -31,6 +31,8 @@ typedef enum {
     AF_NOEOF     = 1 << 1,
 } substaliasflags_T;
 
+extern unsigned long alias_generation;
+
 extern void init_alias(void);
 extern const wchar_t *get_alias_value(const wchar_t *aliasname)
     __attribute__((nonnull,pure));
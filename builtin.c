@@ -164,7 +164,7 @@ void init_builtin(void)
     DEFBUILTIN("bg", fg_builtin, BI_SEMISPECIAL, bg_help, bg_syntax,
 	    help_option);
     DEFBUILTIN("wait", wait_builtin, BI_SEMISPECIAL, wait_help, wait_syntax,
-	    help_option);
+	    wait_options);
     DEFBUILTIN("disown", disown_builtin, BI_SEMISPECIAL, disown_help,
 	    disown_syntax, all_help_options);
 
@@ -192,6 +192,8 @@ void init_builtin(void)
 	    command_syntax, command_options);
     DEFBUILTIN("type", command_builtin, BI_SEMISPECIAL, type_help, type_syntax,
 	    command_options);
+    DEFBUILTIN("parmap", parmap_builtin, BI_REGULAR, parmap_help,
+	    parmap_syntax, parmap_options);
     DEFBUILTIN("times", times_builtin, BI_SPECIAL, times_help, times_syntax,
 	    help_option);
 
@@ -17,6 +17,9 @@
 
 
 #include "common.h"
+#if F_SETPIPE_SZ_NEEDS_GNU_SOURCE
+# define _GNU_SOURCE 1  /* for F_SETPIPE_SZ on glibc */
+#endif
 #include "exec.h"
 #include <assert.h>
 #include <errno.h>
@@ -30,14 +33,25 @@
 # include <paths.h>
 #endif
 #include <signal.h>
+#if HAVE_POSIX_SPAWN
+# include <spawn.h>
+#endif
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if HAVE_GETRUSAGE
+# include <sys/resource.h>
+#endif
+#include <sys/stat.h>
 #include <sys/times.h>
+#if HAVE_CLOCK_GETTIME
+# include <time.h>
+#endif
 #include <unistd.h>
 #include <wchar.h>
+#include <wctype.h>
 #include "alias.h"
 #include "builtin.h"
 #include "expand.h"
@@ -113,6 +127,20 @@ typedef struct commandinfo_T {
 #define ci_builtin  value.builtin
 #define ci_function value.function
 
+/* cached result of the search for built-ins and functions (see
+ * `exec_simple_command_with_words') */
+typedef struct cmdcache_T {
+    unsigned long funcgen;  /* `function_generation' at the time of search */
+    bool posix;             /* `posixly_correct' at the time of search */
+    commandinfo_T info;     /* result of the search */
+    char *mbsname;          /* multibyte version of `name' */
+    wchar_t name[];         /* command name searched for */
+} cmdcache_T;
+/* The result of searching for built-ins and functions only depends on the
+ * command name, the set of defined functions, and the POSIXly-correct mode,
+ * so the result is valid while these remain unchanged. `mbsname' points to
+ * the end of the same memory block as `name'. */
+
 /* result of `fork_and_wait' */
 typedef struct fork_and_wait_T {
     pid_t cpid;       /* child process ID */
@@ -135,9 +163,34 @@ typedef struct execstate_T {
     bool iterating;         /* true when iterative execution is ongoing */
 } execstate_T;
 
+/* resource usage sampled by the "time" keyword */
+typedef struct timesample_T {
+    double real, user, sys;  /* elapsed and CPU times in seconds */
+    long nvcsw, nivcsw;      /* numbers of voluntary/involuntary switches */
+} timesample_T;
+/* `real' is measured from an arbitrary point, so only the difference between
+ * two samples is meaningful. The CPU times and context switches include those
+ * of the shell and all the awaited child processes. */
+
 static void exec_pipelines(const pipeline_T *p, bool finally_exit);
 static void exec_pipelines_async(const pipeline_T *p)
     __attribute__((nonnull));
+static void exec_pipeline(const pipeline_T *p, bool finally_exit)
+    __attribute__((nonnull));
+static void exec_coproc(const pipeline_T *p)
+    __attribute__((nonnull));
+static int move_coproc_fd(int fd);
+static void close_coproc_fds(void);
+static void remember_coproc_fds(int fromfd, int tofd);
+static void exec_commands_timed(command_T *cs, bool posix)
+    __attribute__((nonnull));
+static void sample_time(timesample_T *t)
+    __attribute__((nonnull));
+static void print_time(const wchar_t *format, const timesample_T *t, long maxrss)
+    __attribute__((nonnull));
+static void print_seconds(xwcsbuf_T *buf, double sec, int precision,
+	bool longformat)
+    __attribute__((nonnull));
 
 static void exec_commands(command_T *cs, exec_T type)
     __attribute__((nonnull));
@@ -152,17 +205,25 @@ static bool is_err_condition_for(const command_T *c)
     __attribute__((pure));
 static inline void next_pipe(pipeinfo_T *pi, bool next)
     __attribute__((nonnull));
+#if HAVE_F_SETPIPE_SZ
+static void set_pipe_size(int fd);
+#endif
 static inline void connect_pipes(pipeinfo_T *pi)
     __attribute__((nonnull));
 
+static int exec_last_command_in_shell(command_T *c, int fd)
+    __attribute__((nonnull));
 static void exec_one_command(command_T *c, bool finally_exit)
     __attribute__((nonnull));
-static void exec_simple_command(const command_T *c, bool finally_exit)
+static void exec_simple_command(command_T *c, bool finally_exit)
     __attribute__((nonnull));
 static bool exec_simple_command_without_words(const command_T *c)
     __attribute__((nonnull,warn_unused_result));
 static bool exec_simple_command_with_words(
-	const command_T *c, int argc, void **argv, bool finally_exit)
+	command_T *c, int argc, void **argv, bool finally_exit)
+    __attribute__((nonnull,warn_unused_result));
+static const cmdcache_T *search_builtin_or_function(
+	command_T *c, const wchar_t *name)
     __attribute__((nonnull,warn_unused_result));
 static void print_xtrace(void *const *argv);
 static void search_command(
@@ -175,10 +236,19 @@ static bool command_not_found_handler(void *const *argv)
     __attribute__((nonnull));
 static wchar_t **invoke_simple_command(const commandinfo_T *ci,
 	int argc, char *argv0, void **argv, bool finally_exit)
+    __attribute__((nonnull));
+#if HAVE_POSIX_SPAWN
+static bool spawn_and_wait(const char *path, int argc, char *argv0,
+	void **argv, fork_and_wait_T *faw)
     __attribute__((nonnull,warn_unused_result));
+#endif
 static void exec_external_program(
 	const char *path, int argc, char *argv0, void **argv, char **envs)
     __attribute__((nonnull));
+static void to_mbsargv(int argc, char *argv0, void **argv, char **mbsargv)
+    __attribute__((nonnull));
+static void free_mbsargv(int argc, char **mbsargv)
+    __attribute__((nonnull));
 static inline int xexecve(
 	const char *path, char *const *argv, char *const *envp)
     __attribute__((nonnull(1)));
@@ -196,6 +266,10 @@ static void exec_if(const command_T *c, bool finally_exit)
 static inline bool exec_condition(const and_or_T *c);
 static void exec_for(const command_T *c, bool finally_exit)
     __attribute__((nonnull));
+static bool exec_for_word(wchar_t *word, void *data)
+    __attribute__((nonnull));
+static bool exec_for_body(const command_T *c, wchar_t *word, bool finally_exit)
+    __attribute__((nonnull));
 static void exec_while(const command_T *c, bool finally_exit)
     __attribute__((nonnull));
 static void exec_case(const command_T *c, bool finally_exit)
@@ -222,6 +296,14 @@ int exitstatus = -1;  // -1 if not executing the EXIT trap
 /* the process ID of the last asynchronous list */
 pid_t lastasyncpid;
 
+/* the shell's ends of the pipes to the last coprocess, which are closed when a
+ * new coprocess is started (-1 if none) */
+static int coproc_fds[2] = { -1, -1, };
+/* the results of `fstat'ing `coproc_fds' when the coprocess was started, which
+ * are used to avoid closing file descriptors that have been reused for another
+ * file */
+static struct stat coproc_fds_stat[2];
+
 /* This flag is set to true while the shell is executing the condition of an if-
  * statement, an and-or list, etc. to suppress the effect of the "errexit" and
  * "errreturn" options. */
@@ -331,14 +413,10 @@ void exec_pipelines(const pipeline_T *p, bool finally_exit)
 	suppresserrexit |= suppress;
 	suppresserrreturn |= suppress;
 
-	bool self = finally_exit && !p->next && !p->pl_neg;
-	exec_commands(p->pl_commands, self ? E_SELF : E_NORMAL);
-	if (p->pl_neg) {
-	    if (laststatus == Exit_SUCCESS)
-		laststatus = Exit_FAILURE;
-	    else
-		laststatus = Exit_SUCCESS;
-	}
+	if (p->pl_coproc)
+	    exec_coproc(p);
+	else
+	    exec_pipeline(p, finally_exit && !p->next);
 
 	suppresserrexit = savesee, suppresserrreturn = saveser;
     }
@@ -346,10 +424,34 @@ void exec_pipelines(const pipeline_T *p, bool finally_exit)
 	exit_shell();
 }
 
+/* Executes the commands of the pipeline, applying the "time" and "!" prefixes
+ * of the pipeline. The "coproc" prefix is ignored.
+ * If `finally_exit' is true, the shell may exit after execution. */
+void exec_pipeline(const pipeline_T *p, bool finally_exit)
+{
+    bool self = finally_exit && !p->pl_neg && !p->pl_time;
+    if (p->pl_time)
+	exec_commands_timed(p->pl_commands, p->pl_timep);
+    else
+	exec_commands(p->pl_commands, self ? E_SELF : E_NORMAL);
+    if (p->pl_neg) {
+	if (laststatus == Exit_SUCCESS)
+	    laststatus = Exit_FAILURE;
+	else
+	    laststatus = Exit_SUCCESS;
+    }
+}
+
 /* Executes the pipelines asynchronously. */
 void exec_pipelines_async(const pipeline_T *p)
 {
-    if (p->next == NULL && !p->pl_neg) {
+    int signum = wait_for_job_slot();
+    if (signum != 0) {
+	laststatus = signum + TERMSIGOFFSET;
+	return;
+    }
+
+    if (p->next == NULL && !p->pl_neg && !p->pl_time && !p->pl_coproc) {
 	exec_commands(p->pl_commands, E_ASYNC);
 	return;
     }
@@ -388,6 +490,315 @@ void exec_pipelines_async(const pipeline_T *p)
     }
 }
 
+/* Starts the pipeline as a coprocess.
+ * The standard input and output of the coprocess are connected to the shell
+ * via pipes. The shell's ends of the pipes are set to the $COPROC array (the
+ * reading end first) and the process ID to $COPROC_PID. The coprocess is
+ * registered as an asynchronous job. The shell's ends of the pipes to the
+ * previous coprocess are closed so that it sees the end of its input. */
+void exec_coproc(const pipeline_T *p)
+{
+    int signum = wait_for_job_slot();
+    if (signum != 0) {
+	laststatus = signum + TERMSIGOFFSET;
+	return;
+    }
+
+    close_coproc_fds();
+
+    /* `input' carries data to the coprocess and `output' from it. */
+    pipeinfo_T input = PIPEINFO_INIT, output = PIPEINFO_INIT;
+    next_pipe(&input, true);
+    if (input.pi_tonextfds[PIPE_IN] < 0)
+	goto fail;
+    next_pipe(&output, true);
+    if (output.pi_tonextfds[PIPE_IN] < 0) {
+	xclose(input.pi_tonextfds[PIPE_IN]);
+	xclose(input.pi_tonextfds[PIPE_OUT]);
+	goto fail;
+    }
+
+    pid_t cpid = fork_and_reset(0, false, t_quitint);
+
+    if (cpid > 0) {
+	/* parent process: add a new job */
+	xclose(input.pi_tonextfds[PIPE_IN]);
+	xclose(output.pi_tonextfds[PIPE_OUT]);
+	int fromfd = move_coproc_fd(output.pi_tonextfds[PIPE_IN]);
+	int tofd = move_coproc_fd(input.pi_tonextfds[PIPE_OUT]);
+	remember_coproc_fds(fromfd, tofd);
+
+	pipeline_T single = *p;
+	single.next = NULL;
+
+	job_T *job = xmalloc(add(sizeof *job, sizeof *job->j_procs));
+	process_T *ps = job->j_procs;
+
+	ps->pr_pid = cpid;
+	ps->pr_status = JS_RUNNING;
+	ps->pr_statuscode = 0;
+	ps->pr_name = pipelines_to_wcs(&single);
+
+	job->j_pgid = doing_job_control_now ? cpid : 0;
+	job->j_status = JS_RUNNING;
+	job->j_statuschanged = true;
+	job->j_legacy = false;
+	job->j_nonotify = false;
+	job->j_pcount = 1;
+
+	set_active_job(job);
+	add_job(shopt_curasync);
+
+	void **fds = xmallocn(3, sizeof *fds);
+	fds[0] = malloc_wprintf(L"%d", fromfd);
+	fds[1] = malloc_wprintf(L"%d", tofd);
+	fds[2] = NULL;
+	set_array(L VAR_COPROC, 2, fds, SCOPE_GLOBAL, false);
+	set_variable(L VAR_COPROC_PID, malloc_wprintf(L"%jd", (intmax_t) cpid),
+		SCOPE_GLOBAL, false);
+
+	laststatus = Exit_SUCCESS;
+	lastasyncpid = cpid;
+	return;
+    } else if (cpid == 0) {
+	/* child process: execute the commands and then exit */
+	pipeinfo_T pi = {
+	    .pi_fromprevfd = input.pi_tonextfds[PIPE_IN],
+	    .pi_tonextfds = {
+		output.pi_tonextfds[PIPE_IN], output.pi_tonextfds[PIPE_OUT], },
+	};
+	xclose(input.pi_tonextfds[PIPE_OUT]);
+	connect_pipes(&pi);
+	suppresserrexit |= p->pl_neg;
+	suppresserrreturn |= p->pl_neg;
+	exec_pipeline(p, true);
+	exit_shell();
+    }
+
+    /* fork failure */
+    xclose(input.pi_tonextfds[PIPE_IN]);
+    xclose(input.pi_tonextfds[PIPE_OUT]);
+    xclose(output.pi_tonextfds[PIPE_IN]);
+    xclose(output.pi_tonextfds[PIPE_OUT]);
+fail:
+    laststatus = Exit_NOEXEC;
+}
+
+/* Moves the specified file descriptor to 10 or above so that it is not easily
+ * overridden by redirections, and sets the close-on-exec flag so that it is
+ * not inherited by other commands. The new file descriptor is returned. */
+int move_coproc_fd(int fd)
+{
+    if (fd < 10) {
+	int newfd = fcntl(fd, F_DUPFD, 10);
+	if (newfd >= 0) {
+	    xclose(fd);
+	    fd = newfd;
+	}
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+/* Closes the shell's ends of the pipes to the last coprocess unless they have
+ * already been closed or reused for another file. */
+void close_coproc_fds(void)
+{
+    for (size_t i = 0; i < 2; i++) {
+	struct stat st;
+	if (coproc_fds[i] >= 0 && fstat(coproc_fds[i], &st) >= 0 &&
+		stat_result_same_file(&st, &coproc_fds_stat[i]))
+	    xclose(coproc_fds[i]);
+	coproc_fds[i] = -1;
+    }
+}
+
+/* Records the shell's ends of the pipes to the new coprocess for
+ * `close_coproc_fds'. */
+void remember_coproc_fds(int fromfd, int tofd)
+{
+    coproc_fds[0] = fromfd;
+    coproc_fds[1] = tofd;
+    for (size_t i = 0; i < 2; i++)
+	if (fstat(coproc_fds[i], &coproc_fds_stat[i]) < 0)
+	    coproc_fds[i] = -1;
+}
+
+/* Executes the commands in a pipeline and prints the time taken to the
+ * standard error. If `posix' is true, the POSIX format is used instead of
+ * $TIMEFORMAT. */
+void exec_commands_timed(command_T *cs, bool posix)
+{
+    timesample_T start, end;
+#if HAVE_WAIT4
+    long savemaxrss = max_child_rss;
+    max_child_rss = 0;
+#endif
+
+    sample_time(&start);
+    exec_commands(cs, E_NORMAL);
+    sample_time(&end);
+
+    end.real   -= start.real;
+    end.user   -= start.user;
+    end.sys    -= start.sys;
+    end.nvcsw  -= start.nvcsw;
+    end.nivcsw -= start.nivcsw;
+
+#if HAVE_WAIT4
+    long maxrss = max_child_rss;
+    if (max_child_rss < savemaxrss)
+	max_child_rss = savemaxrss;
+#else
+    long maxrss = 0;
+#endif
+
+    const wchar_t *format;
+    if (posix) {
+	format = L"real %2R\nuser %2U\nsys %2S";
+    } else {
+	format = getvar(L VAR_TIMEFORMAT);
+	if (format == NULL)
+	    format = L"\nreal\t%3lR\nuser\t%3lU\nsys\t%3lS";
+    }
+    print_time(format, &end, maxrss);
+}
+
+/* Samples the current time and resource usage. */
+void sample_time(timesample_T *t)
+{
+#if HAVE_CLOCK_GETTIME
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+	t->real = ts.tv_sec + ts.tv_nsec / 1e9;
+    else
+	t->real = 0.0;
+#else
+    struct tms tms;
+    t->real = times(&tms) / (double) sysconf(_SC_CLK_TCK);
+#endif
+
+#if HAVE_GETRUSAGE
+    struct rusage self, children;
+    if (getrusage(RUSAGE_SELF, &self) != 0)
+	memset(&self, 0, sizeof self);
+    if (getrusage(RUSAGE_CHILDREN, &children) != 0)
+	memset(&children, 0, sizeof children);
+    t->user = self.ru_utime.tv_sec + children.ru_utime.tv_sec +
+	(self.ru_utime.tv_usec + children.ru_utime.tv_usec) / 1e6;
+    t->sys = self.ru_stime.tv_sec + children.ru_stime.tv_sec +
+	(self.ru_stime.tv_usec + children.ru_stime.tv_usec) / 1e6;
+    t->nvcsw = self.ru_nvcsw + children.ru_nvcsw;
+    t->nivcsw = self.ru_nivcsw + children.ru_nivcsw;
+#else
+    double clock = sysconf(_SC_CLK_TCK);
+    struct tms cpu;
+    if (times(&cpu) == (clock_t) -1)
+	memset(&cpu, 0, sizeof cpu);
+    t->user = (cpu.tms_utime + cpu.tms_cutime) / clock;
+    t->sys = (cpu.tms_stime + cpu.tms_cstime) / clock;
+    t->nvcsw = t->nivcsw = 0;
+#endif
+}
+
+/* Prints the time data to the standard error according to `format'.
+ * A newline is appended unless `format' is empty.
+ * The following conversions are available in the format:
+ *   %[p][l]R   elapsed real time
+ *   %[p][l]U   user CPU time
+ *   %[p][l]S   system CPU time
+ *   %P         CPU percentage, (U + S) / R * 100
+ *   %M         maximum resident set size of the child processes
+ *   %w         number of voluntary context switches
+ *   %c         number of involuntary context switches
+ *   %%         a percent sign
+ * "p" is a digit that specifies the number of fractional digits (0-3,
+ * defaulting to 3) and "l" selects the "XmY.YYYs" format. An unknown conversion
+ * is printed intact. */
+void print_time(const wchar_t *format, const timesample_T *t, long maxrss)
+{
+    if (format[0] == L'\0')
+	return;
+
+    xwcsbuf_T buf;
+    wb_init(&buf);
+    for (const wchar_t *s = format; *s != L'\0'; s++) {
+	if (*s != L'%') {
+	    wb_wccat(&buf, *s);
+	    continue;
+	}
+
+	const wchar_t *start = s++;
+	int precision = 3;
+	bool longformat = false;
+	if (iswdigit(*s)) {
+	    precision = *s - L'0';
+	    if (precision > 3)
+		precision = 3;
+	    s++;
+	}
+	if (*s == L'l') {
+	    longformat = true;
+	    s++;
+	}
+
+	switch (*s) {
+	    case L'R':
+		print_seconds(&buf, t->real, precision, longformat);
+		continue;
+	    case L'U':
+		print_seconds(&buf, t->user, precision, longformat);
+		continue;
+	    case L'S':
+		print_seconds(&buf, t->sys, precision, longformat);
+		continue;
+	}
+	if (s == start + 1) {
+	    switch (*s) {
+		case L'%':
+		    wb_wccat(&buf, L'%');
+		    continue;
+		case L'P':
+		    wb_wprintf(&buf, L"%.2f", t->real > 0.0 ?
+			    (t->user + t->sys) / t->real * 100.0 : 0.0);
+		    continue;
+		case L'M':
+		    wb_wprintf(&buf, L"%ld", maxrss);
+		    continue;
+		case L'w':
+		    wb_wprintf(&buf, L"%ld", t->nvcsw);
+		    continue;
+		case L'c':
+		    wb_wprintf(&buf, L"%ld", t->nivcsw);
+		    continue;
+	    }
+	}
+
+	/* unknown conversion */
+	wb_ncat_force(&buf, start, s - start);
+	if (*s == L'\0')
+	    break;
+	wb_wccat(&buf, *s);
+    }
+    fprintf(stderr, "%ls\n", buf.contents);
+    fflush(stderr);
+    wb_destroy(&buf);
+}
+
+/* Appends the specified number of seconds to the buffer. */
+void print_seconds(xwcsbuf_T *buf, double sec, int precision, bool longformat)
+{
+    if (sec < 0.0)
+	sec = 0.0;
+    if (longformat) {
+	double min = trunc(sec / 60.0);
+	wb_wprintf(buf, L"%jdm%.*fs", (intmax_t) min, precision,
+		sec - min * 60.0);
+    } else {
+	wb_wprintf(buf, L"%.*f", precision, sec);
+    }
+}
+
 /* Executes the commands in a pipeline. */
 void exec_commands(command_T *const cs, exec_T type)
 {
@@ -403,6 +814,9 @@ void exec_commands(command_T *const cs, exec_T type)
 	goto done;
     }
 
+    bool lastpipe = type != E_ASYNC && !short_circuit &&
+	shopt_lastpipe && !doing_job_control_now;
+
     /* fork a child process for each command in the pipeline */
     pid_t pgid = 0;
     pipeinfo_T pipe = PIPEINFO_INIT;
@@ -416,6 +830,14 @@ void exec_commands(command_T *const cs, exec_T type)
 
 	if (is_last && short_circuit)
 	    goto exec_one_command; /* skip forking */
+	if (is_last && lastpipe) {
+	    /* The last command is executed later in this process. */
+	    p->pr_pid = 0;
+	    p->pr_status = JS_DONE;
+	    p->pr_statuscode = Exit_SUCCESS;
+	    p->pr_name = NULL;
+	    break;
+	}
 
 	sigtype_T sigtype = (type == E_ASYNC) ? t_quitint : 0;
 	pid_t pid = fork_and_reset(pgid, type == E_NORMAL, sigtype);
@@ -446,8 +868,6 @@ exec_one_command: /* child process */
 
     assert(pipe.pi_tonextfds[PIPE_IN] < 0);
     assert(pipe.pi_tonextfds[PIPE_OUT] < 0);
-    if (pipe.pi_fromprevfd >= 0)
-	xclose(pipe.pi_fromprevfd); /* close the leftover pipe */
 
     /* establish the job and wait for it */
     job->j_pgid = doing_job_control_now ? pgid : 0;
@@ -457,11 +877,24 @@ exec_one_command: /* child process */
     job->j_nonotify = false;
     job->j_pcount = count;
     set_active_job(job);
+    if (lastpipe) {
+	/* The job is kept out of the job list while the last command is
+	 * running because the command may execute other jobs. */
+	park_active_job();
+	p->pr_statuscode = exec_last_command_in_shell(c, pipe.pi_fromprevfd);
+	pipe.pi_fromprevfd = -1;
+	unpark_job(job);
+    }
+    if (pipe.pi_fromprevfd >= 0)
+	xclose(pipe.pi_fromprevfd); /* close the leftover pipe */
     if (type != E_ASYNC) {
 	wait_for_job(ACTIVE_JOBNO, doing_job_control_now, false, false);
 	if (doing_job_control_now)
 	    put_foreground(shell_pgid);
 	laststatus = calc_status_of_job(job);
+#if HAVE_WAIT4
+	set_rusage_variable(job);
+#endif
     } else {
 	laststatus = forkstatus;
 	lastasyncpid = job->j_procs[count - 1].pr_pid;
@@ -601,6 +1034,9 @@ void next_pipe(pipeinfo_T *pi, bool next)
 		goto fail;
 	    }
 	}
+#if HAVE_F_SETPIPE_SZ
+	set_pipe_size(pi->pi_tonextfds[PIPE_OUT]);
+#endif
     } else {
 	pi->pi_tonextfds[PIPE_IN] = pi->pi_tonextfds[PIPE_OUT] = -1;
     }
@@ -611,6 +1047,27 @@ fail:
     xerror(errno, Ngt("cannot open a pipe"));
 }
 
+#if HAVE_F_SETPIPE_SZ
+
+/* Sets the capacity of the pipe to the value of $YASH_PIPE_SIZE.
+ * If the variable is not set or its value is not a positive integer, the pipe
+ * is left intact. Failure in changing the capacity is silently ignored since
+ * the pipe is still usable. */
+void set_pipe_size(int fd)
+{
+    const wchar_t *v = getvar(L VAR_YASH_PIPE_SIZE);
+    if (v == NULL)
+	return;
+
+    int size;
+    if (!xwcstoi(v, 10, &size) || size <= 0)
+	return;
+
+    (void) fcntl(fd, F_SETPIPE_SZ, size);
+}
+
+#endif /* HAVE_F_SETPIPE_SZ */
+
 /* Connects the pipe(s) and closes the pipes left. */
 void connect_pipes(pipeinfo_T *pi)
 {
@@ -626,6 +1083,26 @@ void connect_pipes(pipeinfo_T *pi)
 	xclose(pi->pi_tonextfds[PIPE_IN]);
 }
 
+/* Executes the last command of a pipeline in the current shell process.
+ * The standard input is connected to `fd' (the reading end of the pipe from
+ * the previous process) during the execution and then restored. `fd' is closed
+ * in this function. If `fd' is negative, the standard input is not changed.
+ * Returns the exit status of the command. */
+int exec_last_command_in_shell(command_T *c, int fd)
+{
+    savefd_T *savefd = NULL;
+    if (fd >= 0) {
+	save_fd(STDIN_FILENO, &savefd);
+	xdup2(fd, STDIN_FILENO);
+	xclose(fd);
+    }
+
+    exec_one_command(c, false);
+
+    undo_redirections(savefd);
+    return laststatus;
+}
+
 /* Executes the command. */
 void exec_one_command(command_T *c, bool finally_exit)
 {
@@ -656,7 +1133,7 @@ void exec_one_command(command_T *c, bool finally_exit)
 }
 
 /* Executes the simple command. */
-void exec_simple_command(const command_T *c, bool finally_exit)
+void exec_simple_command(command_T *c, bool finally_exit)
 {
     lastcmdsubstatus = Exit_SUCCESS;
 
@@ -728,13 +1205,14 @@ bool exec_simple_command_without_words(const command_T *c)
  * process. However, this function still may return in some cases.
  * Returns true if the shell should exit. */
 bool exec_simple_command_with_words(
-	const command_T *c, int argc, void **argv, bool finally_exit)
+	command_T *c, int argc, void **argv, bool finally_exit)
 {
     assert(argc > 0);
 
-    char *argv0 = malloc_wcstombs(argv[0]);
-    if (argv0 == NULL)
-	argv0 = xstrdup("");
+    /* check if the command is a special built-in or function */
+    const cmdcache_T *cache = search_builtin_or_function(c, argv[0]);
+    commandinfo_T cmdinfo = cache->info;
+    char *argv0 = cache->mbsname, *argv0copy = NULL;
 
     /* open redirections */
     savefd_T *savefd;
@@ -749,9 +1227,6 @@ bool exec_simple_command_with_words(
 
     last_assign = c->c_assigns;
 
-    /* check if the command is a special built-in or function */
-    commandinfo_T cmdinfo;
-    search_command(argv0, argv[0], &cmdinfo, SCT_BUILTIN | SCT_FUNCTION);
     special_builtin_executed = (cmdinfo.type == CT_SPECIALBUILTIN);
 
     /* open a temporary variable environment */
@@ -775,6 +1250,9 @@ bool exec_simple_command_with_words(
 	search_command(argv0, argv[0], &cmdinfo,
 		SCT_EXTERNAL | SCT_BUILTIN | SCT_CHECK);
 	if (cmdinfo.type == CT_NONE) {
+	    /* The handler may execute this command recursively, which may
+	     * overwrite the cache, so we need our own copy of the name. */
+	    argv0 = argv0copy = xstrdup(argv0);
 	    if (!posixly_correct && command_not_found_handler(argv))
 		goto done1;
 	    if (wcschr(argv[0], L'/') != NULL) {
@@ -804,11 +1282,46 @@ done1:
 	close_current_environment();
 done:
     undo_redirections(savefd);
-    free(argv0);
+    free(argv0copy);
 
     return finally_exit;
 }
 
+/* Searches for a built-in or function named `name', which is the expanded
+ * command name of simple command `c'.
+ * The result is cached in `c->c_cmdcache' and reused in the next search while
+ * it is valid. The returned cache is valid until the next call to this function
+ * with the same `c', which must not be freed in the meantime. */
+const cmdcache_T *search_builtin_or_function(command_T *c, const wchar_t *name)
+{
+    cmdcache_T *cache = c->c_cmdcache;
+    if (cache != NULL
+	    && cache->funcgen == function_generation
+	    && cache->posix == posixly_correct
+	    && wcscmp(cache->name, name) == 0)
+	return cache;
+
+    char *mbsname = malloc_wcstombs(name);
+    if (mbsname == NULL)
+	mbsname = xstrdup("");
+
+    size_t namelen = wcslen(name), mbsnamelen = strlen(mbsname);
+    free(cache);
+    cache = xmallocs(add(sizeof *cache, mbsnamelen + 1),
+	    add(namelen, 1), sizeof *cache->name);
+    wmemcpy(cache->name, name, namelen + 1);
+    cache->mbsname = (char *) &cache->name[namelen + 1];
+    memcpy(cache->mbsname, mbsname, mbsnamelen + 1);
+    free(mbsname);
+
+    cache->funcgen = function_generation;
+    cache->posix = posixly_correct;
+    search_command(cache->mbsname, cache->name, &cache->info,
+	    SCT_BUILTIN | SCT_FUNCTION);
+    c->c_cmdcache = cache;
+    return cache;
+}
+
 /* Returns a pointer to the xtrace buffer.
  * The buffer is initialized if not. */
 xwcsbuf_T *get_xtrace_buffer(void)
@@ -991,6 +1504,7 @@ bool command_not_found_handler(void *const *argv)
 
 /* Invokes the simple command. */
 /* `argv0' is the multibyte version of `argv[0]' */
+/* If `finally_exit' is true, this function never returns. */
 wchar_t **invoke_simple_command(
 	const commandinfo_T *ci, int argc, char *argv0, void **argv,
 	bool finally_exit)
@@ -1006,6 +1520,10 @@ wchar_t **invoke_simple_command(
 	break;
     case CT_EXTERNALPROGRAM:
 	if (!finally_exit) {
+#if HAVE_POSIX_SPAWN
+	    if (spawn_and_wait(ci->ci_path, argc, argv0, argv, &faw))
+		break;
+#endif
 	    faw = fork_and_wait(t_leave);
 	    if (faw.cpid != 0)
 		break;
@@ -1044,13 +1562,7 @@ void exec_external_program(
 	const char *path, int argc, char *argv0, void **argv, char **envs)
 {
     char *mbsargv[argc + 1];
-    mbsargv[0] = argv0;
-    for (int i = 1; i < argc; i++) {
-	mbsargv[i] = malloc_wcstombs(argv[i]);
-	if (mbsargv[i] == NULL)
-	    mbsargv[i] = xstrdup("");
-    }
-    mbsargv[argc] = NULL;
+    to_mbsargv(argc, argv0, argv, mbsargv);
 
     restore_signals(true);
 
@@ -1071,6 +1583,69 @@ void exec_external_program(
 
     set_signals();
 
+    free_mbsargv(argc, mbsargv);
+}
+
+#if HAVE_POSIX_SPAWN
+
+/* Starts the external program by `posix_spawn' and waits for it.
+ * Unlike `fork', `posix_spawn' does not need to duplicate the address space of
+ * the shell, so the cost of starting a program does not grow with the memory
+ * usage of the shell.
+ * `posix_spawn' is not used if job control is active (because the child must
+ * be put in the foreground before exec) or the signal handlers need to be reset
+ * in the child. If `posix_spawn' is not used or fails, this function returns
+ * false without waiting for anything, and the caller should fall back on
+ * `fork_and_wait' and `exec_external_program', which also produce the error
+ * message. Otherwise, `faw' is updated like `fork_and_wait' and true is
+ * returned. */
+bool spawn_and_wait(const char *path, int argc, char *argv0, void **argv,
+	fork_and_wait_T *faw)
+{
+    sigset_t mask;
+    if (doing_job_control_now || !get_sigmask_for_spawn(&mask))
+	return false;
+
+    posix_spawnattr_t attr;
+    if (posix_spawnattr_init(&attr) != 0)
+	return false;
+
+    pid_t cpid;
+    char *mbsargv[argc + 1];
+    to_mbsargv(argc, argv0, argv, mbsargv);
+    bool ok = posix_spawnattr_setsigmask(&attr, &mask) == 0 &&
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK) == 0 &&
+	posix_spawn(&cpid, path, NULL, &attr, mbsargv, environ) == 0;
+    free_mbsargv(argc, mbsargv);
+    posix_spawnattr_destroy(&attr);
+    if (!ok)
+	return false;
+
+    faw->cpid = cpid;
+    faw->namep = wait_for_child(cpid, 0, false);
+    return true;
+}
+
+#endif /* HAVE_POSIX_SPAWN */
+
+/* Converts the wide-string arguments into the NULL-terminated array of
+ * multibyte strings `mbsargv', which must have room for `argc + 1' elements.
+ * `argv0' is used as `mbsargv[0]' as is. The other elements must be freed by
+ * `free_mbsargv'. */
+void to_mbsargv(int argc, char *argv0, void **argv, char **mbsargv)
+{
+    mbsargv[0] = argv0;
+    for (int i = 1; i < argc; i++) {
+	mbsargv[i] = malloc_wcstombs(argv[i]);
+	if (mbsargv[i] == NULL)
+	    mbsargv[i] = xstrdup("");
+    }
+    mbsargv[argc] = NULL;
+}
+
+/* Frees the elements of `mbsargv' made by `to_mbsargv'. */
+void free_mbsargv(int argc, char **mbsargv)
+{
     for (int i = 1; i < argc; i++)
 	free(mbsargv[i]);
 }
@@ -1240,6 +1815,16 @@ bool exec_condition(const and_or_T *c)
     return laststatus == Exit_SUCCESS;
 }
 
+/* state of the for command being executed */
+struct for_T {
+    const command_T *command;
+    bool empty;        /* true until the first word is given */
+    wchar_t *pending;  /* the word for the next iteration */
+};
+/* An iteration is executed only after the next word is given or it is known
+ * that there are no more words so that we can tell if the iteration is the
+ * last one. */
+
 /* Executes the for command. */
 void exec_for(const command_T *c, bool finally_exit)
 {
@@ -1247,12 +1832,11 @@ void exec_for(const command_T *c, bool finally_exit)
     execstate.loopnest++;
     execstate.breakloopnest = execstate.loopnest;
 
-    int count;
-    void **words;
+    struct for_T f = { .command = c, .empty = true, .pending = NULL, };
 
     if (c->c_forwords != NULL) {
 	/* expand the words between "in" and "do" of the for command. */
-	if (!expand_line(c->c_forwords, &count, &words)) {
+	if (!expand_line_each(c->c_forwords, exec_for_word, &f)) {
 	    laststatus = Exit_EXPERROR;
 	    apply_errexit_errreturn(NULL);
 	    goto finish;
@@ -1262,9 +1846,68 @@ void exec_for(const command_T *c, bool finally_exit)
 	struct get_variable_T v = get_variable(L"@");
 	assert(v.type == GV_ARRAY && v.values != NULL);
 	save_get_variable_values(&v);
-	count = (int) v.count;
-	words = v.values;
+
+	size_t i = 0;
+	while (i < v.count && exec_for_word(v.values[i++], &f))
+	    ;
+	while (i < v.count)  /* free unused words */
+	    free(v.values[i++]);
+	free(v.values);
+    }
+
+    /* execute the last iteration */
+    if (f.pending != NULL)
+	exec_for_body(c, f.pending, finally_exit);
+    else if (f.empty && c->c_forcmds != NULL)
+	laststatus = Exit_SUCCESS;
+finish:
+    execstate.loopnest--;
+    if (finally_exit)
+	exit_shell();
+}
+
+/* Receives a word that is assigned to the variable of the for command.
+ * This function is called back from `expand_line_each', so `data' is a pointer
+ * to the `for_T' structure.
+ * Returns false if the loop has been exited. */
+bool exec_for_word(wchar_t *word, void *data)
+{
+    struct for_T *f = data;
+    wchar_t *pending = f->pending;
+
+    f->empty = false;
+    f->pending = word;
+    if (pending == NULL || exec_for_body(f->command, pending, false))
+	return true;
+
+    free(f->pending);
+    f->pending = NULL;
+    return false;
+}
+
+/* Executes the body of the for command once.
+ * `word' is a `free'able string that is assigned to the variable.
+ * Returns false if the loop should be exited. */
+bool exec_for_body(const command_T *c, wchar_t *word, bool finally_exit)
+{
+    if (!set_variable(c->c_forname, word,
+		shopt_forlocal && !posixly_correct ? SCOPE_LOCAL : SCOPE_GLOBAL,
+		false)) {
+	laststatus = Exit_ASSGNERR;
+	return false;
+    }
+    exec_and_or_lists(c->c_forcmds, finally_exit);
+
+    if (c->c_forcmds == NULL)
+	handle_signals();
+    if (execstate.breakloopnest < execstate.loopnest)
+	return false;
+    if (exception == E_CONTINUE) {
+	exception = E_NONE;
+	return true;
     }
+    return exception == E_NONE && !is_interrupted();
+}
 
 #define CHECK_LOOP                                      \
     if (execstate.breakloopnest < execstate.loopnest) { \
@@ -1278,34 +1921,6 @@ void exec_for(const command_T *c, bool finally_exit)
 	goto done;                                      \
     } else (void) 0
 
-    int i;
-    for (i = 0; i < count; i++) {
-	if (!set_variable(c->c_forname, words[i],
-		    shopt_forlocal && !posixly_correct ?
-			SCOPE_LOCAL : SCOPE_GLOBAL,
-		    false)) {
-	    laststatus = Exit_ASSGNERR;
-	    goto done;
-	}
-	exec_and_or_lists(c->c_forcmds, finally_exit && i + 1 == count);
-
-	if (c->c_forcmds == NULL)
-	    handle_signals();
-	CHECK_LOOP;
-    }
-
-done:
-    while (++i < count)  /* free unused words */
-	free(words[i]);
-    free(words);
-    if (count == 0 && c->c_forcmds != NULL)
-	laststatus = Exit_SUCCESS;
-finish:
-    execstate.loopnest--;
-    if (finally_exit)
-	exit_shell();
-}
-
 /* Executes the while/until command. */
 /* The exit status of a while/until command is that of `c_whlcmds' executed
  * last.  If `c_whlcmds' is not executed at all, the status is 0 regardless of
@@ -1792,6 +2407,22 @@ static void print_command_path(
 	const char *name, const char *path, bool humanfriendly)
     __attribute__((nonnull));
 
+/* state of an item processed by the "parmap" built-in */
+typedef struct parmapitem_T {
+    job_T *job;        /* job of the worker, or NULL if not running */
+    size_t jobnumber;  /* job number of `job' */
+    int outfd;         /* temporary file the output is saved in, or -1 */
+    int status;        /* exit status of the worker */
+    bool done;         /* true iff the worker has finished (or failed) */
+} parmapitem_T;
+
+static size_t parmap_default_job_count(void);
+static void parmap_start(parmapitem_T *item, const commandinfo_T *ci,
+	char *argv0, const wchar_t *name, const wchar_t *arg, bool capture)
+    __attribute__((nonnull));
+static void parmap_flush(parmapitem_T *item)
+    __attribute__((nonnull));
+
 /* Options for the "break", "continue" and "eval" built-ins. */
 const struct xgetopt_T iter_options[] = {
     { L'i', L"iteration", OPTARG_NONE, false, NULL, },
@@ -2533,6 +3164,299 @@ const char type_syntax[] = Ngt(
 
 #endif
 
+/* Options for the "parmap" built-in. */
+const struct xgetopt_T parmap_options[] = {
+    { L'a', L"status-array", OPTARG_REQUIRED, false, NULL, },
+    { L'g', L"group",        OPTARG_NONE,     false, NULL, },
+    { L'j', L"jobs",         OPTARG_REQUIRED, false, NULL, },
+    { L'k', L"keep-order",   OPTARG_NONE,     false, NULL, },
+#if YASH_ENABLE_HELP
+    { L'-', L"help",         OPTARG_NONE,     false, NULL, },
+#endif
+    { L'\0', NULL, 0, false, NULL, },
+};
+
+/* The "parmap" built-in, which accepts the following options:
+ *  -a array: assign the exit statuses of the items to `array'
+ *  -g: print the output of each item at once when it finishes
+ *  -k: print the output of the items in the order of the operands
+ *  -j count: run `count' workers at a time */
+int parmap_builtin(int argc, void **argv)
+{
+    const wchar_t *arrayname = NULL;
+    bool group = false, keeporder = false;
+    int maxjobs = 0;
+
+    const struct xgetopt_T *opt;
+    xoptind = 0;
+    while ((opt = xgetopt(argv, parmap_options, XGETOPT_POSIX)) != NULL) {
+	switch (opt->shortopt) {
+	    case L'a':
+		arrayname = xoptarg;
+		if (wcschr(arrayname, L'=')) {
+		    xerror(0, Ngt("`%ls' is not a valid variable name"),
+			    arrayname);
+		    return Exit_FAILURE;
+		}
+		break;
+	    case L'g':
+		group = true;
+		break;
+	    case L'j':
+		if (!xwcstoi(xoptarg, 10, &maxjobs)) {
+		    xerror(0, Ngt("`%ls' is not a valid integer"), xoptarg);
+		    return Exit_ERROR;
+		} else if (maxjobs <= 0) {
+		    xerror(0, Ngt("%d is not a positive integer"), maxjobs);
+		    return Exit_ERROR;
+		}
+		break;
+	    case L'k':
+		keeporder = true;
+		break;
+#if YASH_ENABLE_HELP
+	    case L'-':
+		return print_builtin_help(ARGV(0));
+#endif
+	    default:
+		return Exit_ERROR;
+	}
+    }
+
+    if (xoptind == argc)
+	return insufficient_operands_error(1);
+    size_t jobcount = (maxjobs > 0) ?
+	    (size_t) maxjobs : parmap_default_job_count();
+
+    const wchar_t *name = ARGV(xoptind);
+    char *argv0 = malloc_wcstombs(name);
+    if (argv0 == NULL) {
+	xerror(EILSEQ, NULL);
+	return Exit_NOTFOUND;
+    }
+
+    /* The command is searched for only once, and the result is inherited by
+     * all the workers. */
+    commandinfo_T ci;
+    search_command(argv0, name, &ci,
+	    SCT_EXTERNAL | SCT_BUILTIN | SCT_FUNCTION);
+    if (ci.type == CT_NONE) {
+	xerror(0, Ngt("no such command `%s'"), argv0);
+	free(argv0);
+	return Exit_NOTFOUND;
+    }
+
+    size_t count = (size_t) (argc - xoptind - 1);
+    void **args = &argv[xoptind + 1];
+    parmapitem_T *items = xmallocn(count, sizeof *items);
+    size_t *running = xmallocn(jobcount < count ? jobcount : count,
+	    sizeof *running);
+    size_t runcount = 0, next = 0, flushed = 0;
+    bool capture = group || keeporder;
+    int signum = 0;
+
+    for (;;) {
+	/* start new workers as long as there are free slots */
+	while (next < count && runcount < jobcount) {
+	    parmap_start(&items[next], &ci, argv0, name, args[next], capture);
+	    if (!items[next].done)
+		running[runcount++] = next;
+	    next++;
+	}
+
+	/* collect finished workers */
+	bool collected = false;
+	for (size_t i = 0; i < runcount; ) {
+	    parmapitem_T *item = &items[running[i]];
+	    if (item->job->j_status != JS_DONE) {
+		i++;
+		continue;
+	    }
+	    item->status = calc_status_of_job(item->job);
+	    item->done = true;
+	    remove_job(item->jobnumber);
+	    item->job = NULL;
+	    if (group)
+		parmap_flush(item);
+	    running[i] = running[--runcount];
+	    collected = true;
+	}
+	if (keeporder)
+	    while (flushed < next && items[flushed].done)
+		parmap_flush(&items[flushed++]);
+
+	if (runcount == 0 && next == count)
+	    break;
+	if (!collected) {
+	    signum = wait_for_sigchld(doing_job_control_now, true);
+	    if (signum != 0)
+		break;
+	}
+    }
+
+    int status = Exit_SUCCESS;
+    if (signum == 0) {
+	void **statuses = xmallocn(count + 1, sizeof *statuses);
+	for (size_t i = 0; i < count; i++) {
+	    if (status == Exit_SUCCESS)
+		status = items[i].status;
+	    statuses[i] = malloc_wprintf(L"%d", items[i].status);
+	}
+	statuses[count] = NULL;
+	if (arrayname != NULL) {
+	    if (set_array(arrayname, count, statuses,
+			SCOPE_GLOBAL, shopt_allexport) == NULL)
+		status = Exit_FAILURE;
+	} else {
+	    plfree(statuses, free);
+	}
+    } else {
+	/* The workers that are still running are left as usual jobs. Their
+	 * output is discarded if it is being saved. */
+	for (size_t i = 0; i < runcount; i++)
+	    items[running[i]].job->j_nonotify = false;
+	for (size_t i = 0; i < next; i++) {
+	    if (items[i].outfd >= 0) {
+		remove_shellfd(items[i].outfd);
+		xclose(items[i].outfd);
+	    }
+	}
+	assert(TERMSIGOFFSET >= 128);
+	status = signum + TERMSIGOFFSET;
+    }
+
+    free(running);
+    free(items);
+    free(argv0);
+    return status;
+}
+
+/* Returns the default number of workers for the "parmap" built-in, which is
+ * the number of online processors. */
+size_t parmap_default_job_count(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count > 0)
+	return (size_t) count;
+#endif
+    return 1;
+}
+
+/* Starts a worker process for an item of the "parmap" built-in. The worker
+ * executes the command specified by `ci', `argv0', and `name' with `arg' as
+ * the only argument. If `capture' is true, the standard output of the worker is
+ * redirected to a temporary file, which can be printed by `parmap_flush'.
+ * If the worker cannot be started, the item's `done' flag is set. */
+void parmap_start(parmapitem_T *item, const commandinfo_T *ci,
+	char *argv0, const wchar_t *name, const wchar_t *arg, bool capture)
+{
+    item->job = NULL;
+    item->outfd = -1;
+    item->status = Exit_NOEXEC;
+    item->done = true;
+
+    int fd = -1;
+    if (capture) {
+	char *tempfile;
+	fd = create_temporary_file(&tempfile, "", 0);
+	if (fd < 0) {
+	    xerror(errno, Ngt("cannot create a temporary file"));
+	    return;
+	}
+	if (unlink(tempfile) < 0)
+	    xerror(errno, Ngt("failed to remove temporary file `%s'"),
+		    tempfile);
+	free(tempfile);
+    }
+
+    pid_t cpid = fork_and_reset(0, false, t_quitint);
+    if (cpid == 0) {
+	/* child process: execute the command and then exit */
+	if (fd >= 0) {
+	    xdup2(fd, STDOUT_FILENO);
+	    xclose(fd);
+	}
+	maybe_redirect_stdin_to_devnull();
+
+	void *args[] = { (void *) name, (void *) arg, NULL, };
+	invoke_simple_command(ci, 2, argv0, args, true);
+	assert(false);
+    }
+    if (cpid < 0) {
+	/* fork failure */
+	if (fd >= 0)
+	    xclose(fd);
+	return;
+    }
+
+    /* parent process: add a new job, which is not reported by the usual
+     * notification */
+    job_T *job = xmalloc(add(sizeof *job, sizeof *job->j_procs));
+    process_T *ps = job->j_procs;
+
+    ps->pr_pid = cpid;
+    ps->pr_status = JS_RUNNING;
+    ps->pr_statuscode = 0;
+    ps->pr_name = malloc_wprintf(L"%ls %ls", name, arg);
+
+    job->j_pgid = doing_job_control_now ? cpid : 0;
+    job->j_status = JS_RUNNING;
+    job->j_statuschanged = false;
+    job->j_legacy = false;
+    job->j_nonotify = true;
+    job->j_pcount = 1;
+
+    set_active_job(job);
+    item->job = job;
+    item->jobnumber = add_job(false);
+    item->outfd = move_to_shellfd(fd);
+    item->done = false;
+}
+
+/* Copies the output saved for the item of the "parmap" built-in to the
+ * standard output and closes the temporary file. */
+void parmap_flush(parmapitem_T *item)
+{
+    int fd = item->outfd;
+    if (fd < 0)
+	return;
+
+    if (lseek(fd, 0, SEEK_SET) != 0) {
+	xerror(errno, Ngt("cannot read the temporary file"));
+    } else {
+	char buf[BUFSIZ];
+	for (;;) {
+	    ssize_t size = read(fd, buf, sizeof buf);
+	    if (size < 0) {
+		if (errno == EINTR)
+		    continue;
+		xerror(errno, Ngt("cannot read the temporary file"));
+		break;
+	    }
+	    if (size == 0)
+		break;
+	    if (!write_all(STDOUT_FILENO, buf, (size_t) size)) {
+		xerror(errno, Ngt("cannot print to the standard output"));
+		break;
+	    }
+	}
+    }
+
+    remove_shellfd(fd);
+    xclose(fd);
+    item->outfd = -1;
+}
+
+#if YASH_ENABLE_HELP
+const char parmap_help[] = Ngt(
+"run a command for each argument in parallel"
+);
+const char parmap_syntax[] = Ngt(
+"\tparmap [-gk] [-a array] [-j count] command [argument...]\n"
+);
+#endif
+
 /* The "times" built-in. */
 int times_builtin(int argc __attribute__((unused)), void **argv)
 {
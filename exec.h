@@ -124,6 +124,13 @@ extern const char command_help[], command_syntax[], type_help[], type_syntax[];
 #endif
 extern const struct xgetopt_T command_options[];
 
+extern int parmap_builtin(int argc, void **argv)
+    __attribute__((nonnull));
+#if YASH_ENABLE_HELP
+extern const char parmap_help[], parmap_syntax[];
+#endif
+extern const struct xgetopt_T parmap_options[];
+
 extern int times_builtin(int argc, void **argv)
     __attribute__((nonnull));
 #if YASH_ENABLE_HELP
@@ -53,6 +53,8 @@ struct expand_four_T {
  * must have as many strings as `valuelist' and each string in `cclist' must
  * have the same length as the corresponding wide string in `valuelist'. */
 
+static inline bool is_plain_word(const wordunit_T *w)
+    __attribute__((pure));
 static plist_T expand_word(const wordunit_T *w)
     __attribute__((warn_unused_result));
 static struct expand_four_T expand_four(const wordunit_T *restrict w,
@@ -69,6 +71,8 @@ static wchar_t *expand_tilde(const wchar_t **ss,
 
 enum indextype_T { IDX_NONE, IDX_ALL, IDX_CONCAT, IDX_NUMBER, };
 
+static const wchar_t *plain_param_value(const paramexp_T *p)
+    __attribute__((nonnull));
 static struct expand_four_T expand_param(const paramexp_T *p, bool indq)
     __attribute__((nonnull));
 static enum indextype_T parse_indextype(const wchar_t *indexstr)
@@ -97,6 +101,39 @@ static void merge_expand_four(
 	xwcsbuf_T *restrict valuebuf, xstrbuf_T *restrict ccbuf)
     __attribute__((nonnull));
 
+/* data used in streaming expansion */
+struct expand_stream_T {
+    expand_callback_T *callback;  /* the function to pass the results to */
+    void *data;                   /* the argument to `callback' */
+    wchar_t *ifs;                 /* the value of $IFS for field splitting */
+    bool braceexpand, emptylastfield, glob, nullglob;
+    enum wglobflags_T globflags;
+    bool globmatched;             /* set when `wglob_each' found a result */
+    bool stopped;                 /* set when `callback' returned false */
+};
+/* The values of shell options and $IFS are saved in the structure when
+ * streaming starts so that commands executed by `callback' do not affect the
+ * expansion results. */
+
+static bool may_contain_pattern(const struct expand_four_T *e)
+    __attribute__((nonnull,pure));
+static bool field_may_be_pattern(
+	const wchar_t *restrict s, const char *restrict cc)
+    __attribute__((nonnull,pure));
+static void expand_fields(
+	struct expand_four_T *restrict e, plist_T *restrict list)
+    __attribute__((nonnull));
+static bool stream_result(struct expand_stream_T *s, wchar_t *word)
+    __attribute__((nonnull));
+static void stream_split(
+	struct expand_stream_T *restrict s, wchar_t *value, char *cc)
+    __attribute__((nonnull));
+static void stream_glob(struct expand_stream_T *restrict s,
+	const wchar_t *restrict field, const char *restrict cc)
+    __attribute__((nonnull));
+static bool stream_glob_result(wchar_t *path, void *data)
+    __attribute__((nonnull));
+
 /* data used in brace expansion */
 struct brace_expand_T {
     const wchar_t *word;  /* the word to expand */
@@ -104,7 +141,10 @@ struct brace_expand_T {
     void *const *graph;   /* see the comment in the `expand_brace` function */
     plist_T *valuelist;   /* the list to add the results (words) */
     plist_T *cclist;      /* the list to add the results (charcategory_T) */
+    struct expand_stream_T *stream;
 };
+/* If `stream' is non-NULL, the results are passed to `stream_split' instead of
+ * being added to `valuelist' and `cclist'. */
 
 static void expand_brace_each(
 	void *const *restrict values, void *const *restrict ccs,
@@ -112,8 +152,11 @@ static void expand_brace_each(
     __attribute__((nonnull));
 static void expand_brace(
 	wchar_t *restrict word, char *restrict cc,
-	plist_T *restrict valuelist, plist_T *restrict cclist)
-    __attribute__((nonnull));
+	plist_T *restrict valuelist, plist_T *restrict cclist,
+	struct expand_stream_T *stream)
+    __attribute__((nonnull(1,2)));
+static inline bool brace_expand_stopped(const struct brace_expand_T *e)
+    __attribute__((nonnull,pure));
 static void generate_brace_expand_results(
 	const struct brace_expand_T *restrict e, size_t ci,
 	xwcsbuf_T *restrict valuebuf, xstrbuf_T *restrict ccbuf)
@@ -122,17 +165,35 @@ static bool try_expand_brace_sequence(
 	const struct brace_expand_T *restrict e, size_t ci,
 	xwcsbuf_T *restrict valuebuf, xstrbuf_T *restrict ccbuf)
     __attribute__((nonnull));
+static wchar_t *format_brace_number(long value, int width, bool sign)
+    __attribute__((malloc,warn_unused_result));
 static bool has_leading_zero(const wchar_t *restrict s, bool *restrict sign)
     __attribute__((nonnull));
 
-static void fieldsplit(void **restrict valuelist, void **restrict cclist,
-	plist_T *restrict outvaluelist, plist_T *restrict outcclist)
+static void fieldsplit(wchar_t *restrict s, const char *restrict cc,
+	const wchar_t *restrict ifs, plist_T *restrict fields)
     __attribute__((nonnull));
-static bool is_ifs_char(wchar_t c, charcategory_T cc, const wchar_t *ifs)
+
+/* IFS characters classified for quick lookup in field splitting */
+struct ifsclass_T {
+    wchar_t *ifs;
+    uint_least32_t ifschars[4], ifsspaces[4];
+};
+/* `ifs' is a copy of the value of $IFS the classifier was built for.
+ * `ifschars' and `ifsspaces' are bitmaps of ASCII characters (0-127) that are
+ * IFS characters and IFS whitespaces, respectively. Other characters are
+ * looked up in the `ifs' string. */
+
+static const struct ifsclass_T *get_ifsclass(const wchar_t *ifs)
+    __attribute__((nonnull));
+static inline bool is_ifs_char(
+	wchar_t c, charcategory_T cc, const struct ifsclass_T *ic)
     __attribute__((nonnull,pure));
-static bool is_ifs_whitespace(wchar_t c, charcategory_T cc, const wchar_t *ifs)
+static inline bool is_ifs_whitespace(
+	wchar_t c, charcategory_T cc, const struct ifsclass_T *ic)
     __attribute__((nonnull,pure));
-static bool is_non_ifs_char(wchar_t c, charcategory_T cc, const wchar_t *ifs)
+static inline bool is_non_ifs_char(
+	wchar_t c, charcategory_T cc, const struct ifsclass_T *ic)
     __attribute__((nonnull,pure));
 static void add_empty_field(plist_T *dest, const wchar_t *p)
     __attribute__((nonnull));
@@ -148,8 +209,9 @@ static wchar_t *quote_removal_free(
 
 static enum wglobflags_T get_wglobflags(void)
     __attribute__((pure));
-static void glob_all(
-	struct expand_four_T *restrict e, plist_T *restrict results)
+static void glob_field(const wchar_t *restrict field, const char *restrict cc,
+	enum wglobflags_T flags, plist_T *restrict results,
+	bool *restrict unblock)
     __attribute__((nonnull));
 
 static void maybe_exit_on_error(void);
@@ -185,6 +247,91 @@ bool expand_line(void *const *restrict args,
     return true;
 }
 
+/* Expands a command line like `expand_line', but passes each resulting word to
+ * `callback' rather than returning an array of them.
+ * The word passed to `callback' is a newly malloced wide string, which the
+ * callback is responsible to free. If `callback' returns false, the remaining
+ * words are discarded. `data' is passed to `callback' as is.
+ * The last word in `args' is not expanded to the end before `callback' is
+ * called: results of brace expansion and field splitting are produced one by
+ * one as `callback' consumes them so that the whole list of the resulting
+ * words does not have to be kept in memory. This does not affect the results
+ * unless the last word is subject to pathname expansion, in which case the
+ * word is fully expanded in advance. If the `forlazyglob' option is set,
+ * however, pathname expansion is also performed while `callback' consumes the
+ * results, which are not sorted then.
+ * Returns false on expansion error, in which case `callback' is never called.
+ * On error in a non-interactive shell, the shell exits. */
+bool expand_line_each(void *const *restrict args,
+	expand_callback_T *callback, void *data)
+{
+    if (*args == NULL)
+	return true;
+
+    plist_T list;
+    pl_init(&list);
+
+    for (; args[1] != NULL; args++) {
+	if (!expand_multiple(args[0], &list)) {
+	    plfree(pl_toary(&list), free);
+	    return false;
+	}
+    }
+
+    /* four expansions of the last word */
+    struct expand_four_T expand =
+	expand_four(args[0], TT_SINGLE, Q_WORD, CC_LITERAL);
+    if (expand.valuelist.contents == NULL) {
+	plfree(pl_toary(&list), free);
+	maybe_exit_on_error();
+	return false;
+    }
+
+    bool lazy = !shopt_glob || shopt_forlazyglob ||
+	!may_contain_pattern(&expand);
+    if (!lazy)
+	expand_fields(&expand, &list);
+
+    const wchar_t *ifs = getvar(L VAR_IFS);
+    struct expand_stream_T s = {
+	.callback = callback,
+	.data = data,
+	.ifs = xwcsdup(ifs != NULL ? ifs : DEFAULT_IFS),
+	.braceexpand = shopt_braceexpand,
+	.emptylastfield = shopt_emptylastfield,
+	.glob = shopt_glob,
+	.nullglob = shopt_nullglob,
+	.globflags = get_wglobflags() | WGLB_NOSORT,
+	.stopped = false,
+    };
+
+    /* pass the results of the preceding words */
+    for (size_t i = 0; i < list.length; i++) {
+	if (s.stopped)
+	    free(list.contents[i]);
+	else
+	    stream_result(&s, list.contents[i]);
+    }
+    pl_destroy(&list);
+
+    /* expand and pass the results of the last word */
+    if (lazy) {
+	for (size_t i = 0; i < expand.valuelist.length; i++) {
+	    if (s.braceexpand)
+		expand_brace(expand.valuelist.contents[i],
+			expand.cclist.contents[i], NULL, NULL, &s);
+	    else
+		stream_split(&s, expand.valuelist.contents[i],
+			expand.cclist.contents[i]);
+	}
+	pl_destroy(&expand.valuelist);
+	pl_destroy(&expand.cclist);
+    }
+
+    free(s.ifs);
+    return true;
+}
+
 /* Expands a word.
  * The results, which are added to `list' as newly-malloced wide strings, may
  * be multiple words.
@@ -192,6 +339,11 @@ bool expand_line(void *const *restrict args,
  * On error in a non-interactive shell, the shell exits. */
 bool expand_multiple(const wordunit_T *w, plist_T *list)
 {
+    if (is_plain_word(w)) {
+	pl_add(list, xwcsdup(w->wu_string));
+	return true;
+    }
+
     /* four expansions (w -> valuelist) */
     struct expand_four_T expand = expand_four(w, TT_SINGLE, Q_WORD, CC_LITERAL);
     if (expand.valuelist.contents == NULL) {
@@ -199,30 +351,7 @@ bool expand_multiple(const wordunit_T *w, plist_T *list)
 	return false;
     }
 
-    /* brace expansion (valuelist -> valuelist2) */
-    plist_T valuelist2, cclist2;
-    if (shopt_braceexpand) {
-	pl_init(&valuelist2);
-	pl_init(&cclist2);
-	expand_brace_each(expand.valuelist.contents, expand.cclist.contents,
-		&valuelist2, &cclist2);
-	pl_truncate(&expand.valuelist, 0);
-	pl_truncate(&expand.cclist, 0);
-    } else {
-	valuelist2 = expand.valuelist;
-	cclist2 = expand.cclist;
-	pl_init(&expand.valuelist);
-	pl_init(&expand.cclist);
-    }
-
-    /* field splitting (valuelist2 -> valuelist) */
-    fieldsplit(pl_toary(&valuelist2), pl_toary(&cclist2),
-	    &expand.valuelist, &expand.cclist);
-    assert(expand.valuelist.length == expand.cclist.length);
-
-    /* pathname expansion (and quote removal) */
-    glob_all(&expand, list);
-
+    expand_fields(&expand, list);
     return true;
 }
 
@@ -294,6 +423,23 @@ plist_T expand_word(const wordunit_T *w)
     return expand.valuelist;
 }
 
+/* Checks if the specified word consists of a single plain literal word unit.
+ * Such a word expands to the string of the word unit as is. */
+bool is_plain_word(const wordunit_T *w)
+{
+    return w != NULL && w->next == NULL &&
+	w->wu_type == WT_STRING && w->wu_plain;
+}
+
+/* Returns true if the specified string contains no characters that are subject
+ * to tilde expansion, brace expansion, pathname expansion, or quote removal.
+ * The characters of such a string remain intact through all the expansions
+ * whatever shell options are set. */
+bool is_plain_literal(const wchar_t *s)
+{
+    return wcspbrk(s, L"\"'\\~{*?[") == NULL;
+}
+
 /* Expands a single word: the four expansions and quote removal.
  * This function doesn't perform brace expansion, field splitting, or globbing.
  * If successful, the resulting word is returned as a newly malloced string.
@@ -302,6 +448,9 @@ plist_T expand_word(const wordunit_T *w)
 wchar_t *expand_single(const wordunit_T *w,
 	tildetype_T tilde, quoting_T quoting, escaping_T escaping)
 {
+    if (is_plain_word(w))
+	return xwcsdup(w->wu_string);
+
     cc_word_T e = expand_single_cc(w, tilde, quoting);
     if (e.value == NULL)
 	return NULL;
@@ -321,11 +470,18 @@ wchar_t *expand_single(const wordunit_T *w,
  * On error in a non-interactive shell, the shell exits. */
 char *expand_single_with_glob(const wordunit_T *arg)
 {
+    if (is_plain_word(arg)) {
+	char *mbresult = malloc_wcstombs(arg->wu_string);
+	if (mbresult == NULL)
+	    xerror(EILSEQ, Ngt("redirection"));
+	return mbresult;
+    }
+
     cc_word_T e = expand_single_cc(arg, TT_SINGLE, Q_WORD);
     if (e.value == NULL)
 	goto return_null;
 
-    if (!shopt_glob)
+    if (!shopt_glob || !field_may_be_pattern(e.value, e.cc))
 	goto quote_removal;
 
     wchar_t *pattern = quote_removal(e.value, e.cc, ES_QUOTED_HARD);
@@ -525,8 +681,16 @@ default_:
 	    }
 	    break;
 	case WT_PARAM:;
-	    struct expand_four_T e2 = expand_param(w->wu_param,
-		    indq || quoting == Q_LITERAL || (defaultcc & CC_QUOTED));
+	    bool paramindq =
+		indq || quoting == Q_LITERAL || (defaultcc & CC_QUOTED);
+	    ss = plain_param_value(w->wu_param);
+	    if (ss != NULL) {
+		wb_cat(&valuebuf, ss);
+		fill_ccbuf(&valuebuf, &ccbuf,
+			CC_SOFT_EXPANSION | (paramindq * CC_QUOTED));
+		break;
+	    }
+	    struct expand_four_T e2 = expand_param(w->wu_param, paramindq);
 	    if (e2.valuelist.contents == NULL)
 		goto failure;
 	    if (e2.valuelist.length == 0) {
@@ -648,6 +812,17 @@ finish:
     return xwcsdup(home);
 }
 
+/* Returns the value of the scalar variable if `p' is a plain parameter
+ * expansion like "$foo" or "${foo}" of a set scalar variable. Otherwise,
+ * returns NULL. Such expansion can be performed without the general machinery
+ * of `expand_param', which makes several temporary copies of the value. */
+const wchar_t *plain_param_value(const paramexp_T *p)
+{
+    if (p->pe_type != PT_NONE || p->pe_start != NULL || !is_name(p->pe_name))
+	return NULL;
+    return getvar(p->pe_name);
+}
+
 /* Performs parameter expansion.
  * If successful, the return value contains valid lists of pointers to newly
  * malloced strings. Note that the lists may contain no strings.
@@ -1199,6 +1374,155 @@ void merge_expand_four(
 }
 
 
+/********** Field Generation **********/
+
+/* Checks if any of the specified fields may result in a pathname expansion
+ * pattern. The check is conservative: the result may be true even if there
+ * will be no pattern after brace expansion and field splitting. */
+bool may_contain_pattern(const struct expand_four_T *e)
+{
+    for (size_t i = 0; i < e->valuelist.length; i++)
+	if (field_may_be_pattern(e->valuelist.contents[i], e->cclist.contents[i]))
+	    return true;
+    return false;
+}
+
+/* Checks if the specified field may be a pathname expansion pattern, that is,
+ * if it contains an unquoted L'*', L'?', or L'[' that did not result from
+ * tilde expansion or numeric brace expansion.
+ * This check is much cheaper than constructing the pattern by `quote_removal'
+ * with ES_QUOTED_HARD, which escapes every quoted character. */
+bool field_may_be_pattern(const wchar_t *restrict s, const char *restrict cc)
+{
+    for (const wchar_t *p = s; (p = wcspbrk(p, L"*?[")) != NULL; p++) {
+	charcategory_T c = cc[p - s];
+	if (!(c & CC_QUOTED) && (c & CC_ORIGIN_MASK) != CC_HARD_EXPANSION)
+	    return true;
+    }
+    return false;
+}
+
+/* Performs brace expansion, field splitting, pathname expansion, and quote
+ * removal on the results of the four expansions.
+ * The lists and their contents in `e' are freed in this function.
+ * The results are added to `list' as newly-malloced wide strings. */
+void expand_fields(struct expand_four_T *restrict e, plist_T *restrict list)
+{
+    /* brace expansion */
+    if (shopt_braceexpand) {
+	plist_T valuelist2, cclist2;
+	pl_init(&valuelist2);
+	pl_init(&cclist2);
+	expand_brace_each(e->valuelist.contents, e->cclist.contents,
+		&valuelist2, &cclist2);
+	pl_destroy(&e->valuelist);
+	pl_destroy(&e->cclist);
+	e->valuelist = valuelist2;
+	e->cclist = cclist2;
+    }
+    assert(e->valuelist.length == e->cclist.length);
+
+    /* field splitting and pathname expansion (and quote removal) */
+    const wchar_t *ifs = getvar(L VAR_IFS);
+    if (ifs == NULL)
+	ifs = DEFAULT_IFS;
+    enum wglobflags_T flags = get_wglobflags();
+    bool unblock = false;
+    plist_T fields;
+    pl_init(&fields);
+    for (size_t i = 0; i < e->valuelist.length; i++) {
+	wchar_t *value = e->valuelist.contents[i];
+	char *cc = e->cclist.contents[i];
+	fieldsplit(value, cc, ifs, &fields);
+	for (size_t j = 0; j < fields.length; j++) {
+	    const wchar_t *field = fields.contents[j];
+	    glob_field(field, &cc[field - value], flags, list, &unblock);
+	}
+	pl_truncate(&fields, 0);
+    }
+    if (unblock)
+	set_interruptible_by_sigint(false);
+    pl_destroy(&fields);
+
+    plfree(pl_toary(&e->valuelist), free);
+    plfree(pl_toary(&e->cclist), free);
+}
+
+/* Passes the specified word to the callback of the stream.
+ * Returns false if the callback requested to stop. */
+bool stream_result(struct expand_stream_T *s, wchar_t *word)
+{
+    assert(!s->stopped);
+    if (!s->callback(word, s->data))
+	s->stopped = true;
+    return !s->stopped;
+}
+
+/* Performs field splitting on the specified word and passes the resulting
+ * fields to `stream_glob'. `value' and `cc' are freed in this function. */
+void stream_split(struct expand_stream_T *restrict s, wchar_t *value, char *cc)
+{
+    if (s->stopped) {
+	free(value);
+	free(cc);
+	return;
+    }
+
+    plist_T fields;
+    pl_init(&fields);
+
+    /* `extract_fields' refers to the current option, which may have been
+     * changed since the stream started. */
+    bool saveemptylastfield = shopt_emptylastfield;
+    shopt_emptylastfield = s->emptylastfield;
+    fieldsplit(value, cc, s->ifs, &fields);
+    shopt_emptylastfield = saveemptylastfield;
+
+    for (size_t j = 0; j < fields.length; j++) {
+	const wchar_t *field = fields.contents[j];
+	stream_glob(s, field, &cc[field - value]);
+    }
+    pl_destroy(&fields);
+    free(value);
+    free(cc);
+}
+
+/* Performs pathname expansion and quote removal on the specified field and
+ * passes the results to the callback of the stream. */
+void stream_glob(struct expand_stream_T *restrict s,
+	const wchar_t *restrict field, const char *restrict cc)
+{
+    if (s->stopped)
+	return;
+
+    wchar_t *pattern = s->glob && field_may_be_pattern(field, cc) ?
+	quote_removal(field, cc, ES_QUOTED_HARD) : NULL;
+    bool globbed = pattern != NULL && is_pathname_matching_pattern(pattern);
+    if (globbed) {
+	s->globmatched = false;
+	set_interruptible_by_sigint(true);
+	wglob_each(pattern, s->globflags, stream_glob_result, s);
+	set_interruptible_by_sigint(false);
+    }
+    if (!globbed || (!s->globmatched && !s->nullglob && !s->stopped))
+	stream_result(s, quote_removal(field, cc, ES_NONE));
+    free(pattern);
+}
+
+/* Callback for `wglob_each' used in `stream_glob'. */
+bool stream_glob_result(wchar_t *path, void *data)
+{
+    struct expand_stream_T *s = data;
+    s->globmatched = true;
+
+    /* SIGINT must not be unblocked while running commands. */
+    set_interruptible_by_sigint(false);
+    bool result = stream_result(s, path);
+    set_interruptible_by_sigint(true);
+    return result;
+}
+
+
 /********** Brace Expansions **********/
 
 /* Performs brace expansion in each element of the specified array.
@@ -1213,7 +1537,7 @@ void expand_brace_each(
 	plist_T *restrict valuelist, plist_T *restrict cclist)
 {
     while (*values != NULL) {
-	expand_brace(*values, *ccs, valuelist, cclist);
+	expand_brace(*values, *ccs, valuelist, cclist, NULL);
 	values++, ccs++;
     }
 }
@@ -1221,10 +1545,13 @@ void expand_brace_each(
 /* Performs brace expansion in the specified single word.
  * `cc' is the charcategory_T string corresponding to `word'.
  * `word' and `cc' are freed in this function.
- * `Free'able results are added to `valuelist' and `cclist'. */
+ * `Free'able results are added to `valuelist' and `cclist' if `stream' is
+ * NULL. Otherwise, the results are passed to `stream_split' as they are
+ * generated and `valuelist' and `cclist' are ignored. */
 void expand_brace(
 	wchar_t *restrict const word, char *restrict const cc,
-	plist_T *restrict valuelist, plist_T *restrict cclist)
+	plist_T *restrict valuelist, plist_T *restrict cclist,
+	struct expand_stream_T *stream)
 {
 #define idx(p) ((size_t) ((wchar_t *) (p) - word))
 
@@ -1232,8 +1559,12 @@ void expand_brace(
     const wchar_t *c;
     if ((c = wcschr(word, L'{')) == NULL || (c = wcschr(c + 1, L'}')) == NULL) {
 no_expansion:
-	pl_add(valuelist, word);
-	pl_add(cclist, cc);
+	if (stream != NULL) {
+	    stream_split(stream, word, cc);
+	} else {
+	    pl_add(valuelist, word);
+	    pl_add(cclist, cc);
+	}
 	return;
     }
 
@@ -1319,6 +1650,7 @@ no_expansion:
 	.graph = graph.contents,
 	.valuelist = valuelist,
 	.cclist = cclist,
+	.stream = stream,
     };
     xwcsbuf_T valuebuf;
     xstrbuf_T ccbuf;
@@ -1353,8 +1685,12 @@ normal:
     switch (e->word[ci]) {
 	case L'\0':
 	    /* No more characters: we're done! */
-	    pl_add(e->valuelist, wb_towcs(valuebuf));
-	    pl_add(e->cclist, sb_tostr(ccbuf));
+	    if (e->stream != NULL) {
+		stream_split(e->stream, wb_towcs(valuebuf), sb_tostr(ccbuf));
+	    } else {
+		pl_add(e->valuelist, wb_towcs(valuebuf));
+		pl_add(e->cclist, sb_tostr(ccbuf));
+	    }
 	    return;
 	case L',':
 	    /* skip up to next L'}' and go on */
@@ -1393,6 +1729,11 @@ normal:
 	sb_ncat_force(&ccbuf2, ccbuf->contents, ccbuf->length);
 	ci++;
 	generate_brace_expand_results(e, ci, &valuebuf2, &ccbuf2);
+	if (brace_expand_stopped(e)) {
+	    wb_destroy(valuebuf);
+	    sb_destroy(ccbuf);
+	    return;
+	}
 	ci = nextdelimiter - e->word;
 	nextdelimiter = e->graph[ci];
     }
@@ -1465,11 +1806,21 @@ bool try_expand_brace_sequence(
 	if (e->cc[ci] & CC_QUOTED)
 	    return false;
 
+    /* If the sequence is the whole word being streamed, the resulting numbers
+     * are not subject to field splitting or pathname expansion, so they can be
+     * passed to the stream directly. */
+    bool direct = e->stream != NULL && starti == 1 && cp[1] == L'\0';
+
     /* expand the sequence */
     long value = start;
     int len = (startlen > endlen) ? startlen : endlen;
     ci = cp - e->word + 1;
     do {
+	if (direct) {
+	    stream_result(e->stream, format_brace_number(value, len, sign));
+	    goto next;
+	}
+
 	xwcsbuf_T valuebuf2;
 	xstrbuf_T ccbuf2;
 	wb_initwithmax(&valuebuf2, valuebuf->maxlength);
@@ -1486,6 +1837,9 @@ bool try_expand_brace_sequence(
 	/* expand the remaining portion recursively */
 	generate_brace_expand_results(e, ci, &valuebuf2, &ccbuf2);
 
+next:
+	if (brace_expand_stopped(e))
+	    break;
 	if (delta >= 0) {
 	    if (LONG_MAX - delta < value)
 		break;
@@ -1501,6 +1855,41 @@ bool try_expand_brace_sequence(
     return true;
 }
 
+/* Returns true if the results of brace expansion are being passed to a stream
+ * that does not accept any more results. */
+bool brace_expand_stopped(const struct brace_expand_T *e)
+{
+    return e->stream != NULL && e->stream->stopped;
+}
+
+/* Formats a number of numeric brace expansion.
+ * The result is a newly malloced string that is the same as what
+ * `L"%0*ld"' (or `L"%0+*ld"' if `sign' is true) would produce. */
+wchar_t *format_brace_number(long value, int width, bool sign)
+{
+    wchar_t digits[sizeof value * CHAR_BIT];
+    size_t n = 0;
+    unsigned long u = (value < 0) ? -(unsigned long) value : (unsigned long) value;
+    do
+	digits[n++] = L'0' + u % 10;
+    while ((u /= 10) != 0);
+
+    wchar_t signchar = (value < 0) ? L'-' : sign ? L'+' : L'\0';
+    size_t length = n + (signchar != L'\0');
+    size_t zeros = (width > 0 && (size_t) width > length) ? width - length : 0;
+
+    wchar_t *result = xmalloce(add(length, zeros), 1, sizeof *result);
+    wchar_t *p = result;
+    if (signchar != L'\0')
+	*p++ = signchar;
+    wmemset(p, L'0', zeros);
+    p += zeros;
+    while (n > 0)
+	*p++ = digits[--n];
+    *p = L'\0';
+    return result;
+}
+
 /* Checks if the specified numeral starts with a L'0'.
  * Leading spaces are ignored.
  * If the numeral has a plus sign L'+', true is assigned to `*sign'.
@@ -1521,50 +1910,29 @@ bool has_leading_zero(const wchar_t *restrict s, bool *restrict sign)
 
 /********** Field Splitting **********/
 
-/* Performs field splitting.
- * `valuelist' is a NULL-terminated array of pointers to wide strings to split.
- * `cclist' is an array of pointers to corresponding charcategory_T strings.
- * `valuelist' and `cclist' are `plfree'ed in this function.
- * The results are added to `outvaluelist' and `outcclist'. */
-void fieldsplit(void **restrict const valuelist, void **restrict const cclist,
-	plist_T *restrict outvaluelist, plist_T *restrict outcclist)
+/* Performs field splitting on the specified word.
+ * `cc' is the charcategory_T string corresponding to `s'.
+ * Pointers to the resulting fields are added to `fields'. The fields are not
+ * copied: they point into `s', which is modified to null-terminate each field.
+ * The corresponding charcategory_T strings are found at the same offsets in
+ * `cc'. */
+void fieldsplit(wchar_t *restrict s, const char *restrict cc,
+	const wchar_t *restrict ifs, plist_T *restrict fields)
 {
-    const wchar_t *ifs = getvar(L VAR_IFS);
-    if (ifs == NULL)
-	ifs = DEFAULT_IFS;
-
-    plist_T fields;
-    pl_init(&fields);
-
-    for (size_t i = 0; valuelist[i] != NULL; i++) {
-	wchar_t *s = valuelist[i];
-	char *cc = cclist[i];
-	extract_fields(s, cc, ifs, &fields);
-	assert(fields.length % 2 == 0);
-
-	if (fields.length == 2 && fields.contents[0] == s &&
-		*(wchar_t *) fields.contents[1] == L'\0') {
-	    /* The result is the same as the original field. */
-	    pl_add(outvaluelist, s);
-	    pl_add(outcclist, cc);
-	} else {
-	    /* Produce new fields. */
-	    for (size_t j = 0; j < fields.length; j += 2) {
-		const wchar_t *start = fields.contents[j];
-		const wchar_t *end = fields.contents[j + 1];
-		size_t idx = start - s, len = end - start;
-		pl_add(outvaluelist, xwcsndup(start, len));
-		pl_add(outcclist, memcpy(xmalloc(len), &cc[idx], len));
-	    }
-	    free(s);
-	    free(cc);
-	}
-
-	pl_truncate(&fields, 0);
+    size_t oldlen = fields->length;
+    extract_fields(s, cc, ifs, fields);
+    assert((fields->length - oldlen) % 2 == 0);
+
+    /* Replace each pair of start and end pointers with the start pointer. The
+     * end of a field is a delimiter (or the end of the string) that is not
+     * part of any other field, so we can overwrite it. */
+    size_t n = oldlen;
+    for (size_t i = oldlen; i < fields->length; i += 2) {
+	wchar_t *end = fields->contents[i + 1];
+	*end = L'\0';
+	fields->contents[n++] = fields->contents[i];
     }
-    pl_destroy(&fields);
-    free(valuelist);
-    free(cclist);
+    pl_truncate(fields, n);
 }
 
 /* Extracts fields from a string.
@@ -1602,6 +1970,17 @@ void fieldsplit(void **restrict const valuelist, void **restrict const cclist,
 wchar_t *extract_fields(const wchar_t *restrict s, const char *restrict cc,
 	const wchar_t *restrict ifs, plist_T *restrict dest)
 {
+    /* Only unquoted results of soft expansions are subject to splitting, so a
+     * non-empty word without them is a single field. This is the case for most
+     * fields including large quoted expansions like "$(cat file)". */
+    size_t length = wcslen(s);
+    if (length > 0 && memchr(cc, CC_SOFT_EXPANSION, length) == NULL) {
+	pl_add(pl_add(dest, s), &s[length]);
+	return (wchar_t *) &s[length];
+    }
+
+    const struct ifsclass_T *ic = get_ifsclass(ifs);
+
     size_t index = 0;
     size_t ifswhitestartindex;
     size_t oldlen = dest->length;
@@ -1612,13 +1991,21 @@ wchar_t *extract_fields(const wchar_t *restrict s, const char *restrict cc,
 
     for (;;) {
 	ifswhitestartindex = index;
-	while (is_ifs_whitespace(s[index], cc[index], ifs))
+	while (is_ifs_whitespace(s[index], cc[index], ic))
 	    index++;
 
 	/* extract next field, if any */
 	size_t fieldstartindex = index;
-	while (is_non_ifs_char(s[index], cc[index], ifs))
-	    index++;
+	while (is_non_ifs_char(s[index], cc[index], ic)) {
+	    if (cc[index] != CC_SOFT_EXPANSION) {
+		/* skip characters that cannot be IFS characters at once */
+		const char *next = memchr(&cc[index], CC_SOFT_EXPANSION,
+			length - index);
+		index = (next != NULL) ? (size_t) (next - cc) : length;
+	    } else {
+		index++;
+	    }
+	}
 	if (index != fieldstartindex) {
 	    pl_add(pl_add(dest, &s[fieldstartindex]), &s[index]);
 	    afterfield = true;
@@ -1634,8 +2021,8 @@ wchar_t *extract_fields(const wchar_t *restrict s, const char *restrict cc,
 	    break;
 
 	/* skip (only) one IFS non-whitespace */
-	assert(is_ifs_char(s[index], cc[index], ifs));
-	assert(!is_ifs_whitespace(s[index], cc[index], ifs));
+	assert(is_ifs_char(s[index], cc[index], ic));
+	assert(!is_ifs_whitespace(s[index], cc[index], ic));
 	index++;
 	afterfield = false;
     }
@@ -1651,22 +2038,56 @@ wchar_t *extract_fields(const wchar_t *restrict s, const char *restrict cc,
     return (wchar_t *) &s[ifswhitestartindex];
 }
 
+/* Returns the classifier for the specified value of $IFS.
+ * The classifier is cached and rebuilt only when the value of $IFS differs
+ * from that of the last call. The result is valid until the next call. */
+const struct ifsclass_T *get_ifsclass(const wchar_t *ifs)
+{
+    static struct ifsclass_T cache;
+    struct ifsclass_T *ic = &cache;
+    if (ic->ifs != NULL && wcscmp(ic->ifs, ifs) == 0)
+	return ic;
+
+    free(ic->ifs);
+    ic->ifs = xwcsdup(ifs);
+    memset(ic->ifschars, 0, sizeof ic->ifschars);
+    memset(ic->ifsspaces, 0, sizeof ic->ifsspaces);
+    for (; *ifs != L'\0'; ifs++) {
+	if (*ifs < 0 || *ifs >= 128)
+	    continue;
+	uint_least32_t bit = (uint_least32_t) 1 << (*ifs % 32);
+	ic->ifschars[*ifs / 32] |= bit;
+	if (iswspace(*ifs))
+	    ic->ifsspaces[*ifs / 32] |= bit;
+    }
+    return ic;
+}
+
 /* Returns true if `c' is a non-null, IFS character. */
-bool is_ifs_char(wchar_t c, charcategory_T cc, const wchar_t *ifs)
+bool is_ifs_char(wchar_t c, charcategory_T cc, const struct ifsclass_T *ic)
 {
-    return cc == CC_SOFT_EXPANSION && c != L'\0' && wcschr(ifs, c) != NULL;
+    if (cc != CC_SOFT_EXPANSION || c == L'\0')
+	return false;
+    if (0 <= c && c < 128)
+	return (ic->ifschars[c / 32] >> (c % 32)) & 1;
+    return wcschr(ic->ifs, c) != NULL;
 }
 
 /* Returns true if `c' is a non-null, IFS-whitespace character. */
-bool is_ifs_whitespace(wchar_t c, charcategory_T cc, const wchar_t *ifs)
+bool is_ifs_whitespace(
+	wchar_t c, charcategory_T cc, const struct ifsclass_T *ic)
 {
-    return is_ifs_char(c, cc, ifs) && iswspace(c);
+    if (cc != CC_SOFT_EXPANSION)
+	return false;
+    if (0 < c && c < 128)
+	return (ic->ifsspaces[c / 32] >> (c % 32)) & 1;
+    return is_ifs_char(c, cc, ic) && iswspace(c);
 }
 
 /* Returns true if `c' is a non-null, non-IFS character. */
-bool is_non_ifs_char(wchar_t c, charcategory_T cc, const wchar_t *ifs)
+bool is_non_ifs_char(wchar_t c, charcategory_T cc, const struct ifsclass_T *ic)
 {
-    return c != L'\0' && !is_ifs_char(c, cc, ifs);
+    return c != L'\0' && !is_ifs_char(c, cc, ic);
 }
 
 void add_empty_field(plist_T *dest, const wchar_t *p)
@@ -1880,13 +2301,22 @@ bool should_escape(charcategory_T cc, escaping_T escaping)
 wchar_t *quote_removal(
 	const wchar_t *restrict s, const char *restrict cc, escaping_T escaping)
 {
+    size_t length = wcslen(s);
     xwcsbuf_T result;
-    wb_initwithmax(&result, mul(wcslen(s), 2));
-    for (size_t i = 0; s[i] != L'\0'; i++) {
+    wb_initwithmax(&result, escaping == ES_NONE ? length : mul(length, 2));
+    for (size_t i = 0; i < length; i++) {
+	/* copy a span of characters that are neither removed nor escaped */
+	size_t start = i;
+	while (i < length &&
+		!(cc[i] & CC_QUOTATION) && !should_escape(cc[i], escaping))
+	    i++;
+	wb_ncat_force(&result, &s[start], i - start);
+	if (i == length)
+	    break;
+
 	if (cc[i] & CC_QUOTATION)
 	    continue;
-	if (should_escape(cc[i], escaping))
-	    wb_wccat(&result, L'\\');
+	wb_wccat(&result, L'\\');
 	wb_wccat(&result, s[i]);
     }
     return wb_towcs(&result);
@@ -1913,47 +2343,41 @@ enum wglobflags_T get_wglobflags(void)
     if (shopt_dotglob)      flags |= WGLB_PERIOD;
     if (shopt_markdirs)     flags |= WGLB_MARK;
     if (shopt_extendedglob) flags |= WGLB_RECDIR;
+    if (shopt_parallelglob) flags |= WGLB_PARALLEL;
     return flags;
 }
 
-/* Performs pathname expansion.
- * If `shopt_glob' is off or a field is not a pattern, quote removal is
+/* Performs pathname expansion on the specified field.
+ * `cc' is the charcategory_T string corresponding to `field'.
+ * If `shopt_glob' is off or the field is not a pattern, quote removal is
  * performed instead.
- * The input lists and their contents in `e' are freed in this function.
- * The results are added to `results' as newly-malloced wide strings. */
-void glob_all(struct expand_four_T *restrict e, plist_T *restrict results)
+ * The results are added to `results' as newly-malloced wide strings.
+ * `*unblock' is set to true when SIGINT is unblocked for globbing, in which
+ * case the caller must block it again by `set_interruptible_by_sigint(false)'
+ * after pathname expansion is done. */
+void glob_field(const wchar_t *restrict field, const char *restrict cc,
+	enum wglobflags_T flags, plist_T *restrict results,
+	bool *restrict unblock)
 {
-    enum wglobflags_T flags = get_wglobflags();
-    bool unblock = false;
-
-    for (size_t i = 0; i < e->valuelist.length; i++) {
-	wchar_t *field = e->valuelist.contents[i];
-	char *cc = e->cclist.contents[i];
-	wchar_t *pattern = quote_removal(field, cc, ES_QUOTED_HARD);
-	if (shopt_glob && is_pathname_matching_pattern(pattern)) {
-	    if (!unblock) {
-		set_interruptible_by_sigint(true);
-		unblock = true;
-	    }
+    wchar_t *pattern = shopt_glob && field_may_be_pattern(field, cc) ?
+	quote_removal(field, cc, ES_QUOTED_HARD) : NULL;
+    if (pattern != NULL && is_pathname_matching_pattern(pattern)) {
+	if (!*unblock) {
+	    set_interruptible_by_sigint(true);
+	    *unblock = true;
+	}
 
-	    size_t oldlen = results->length;
-	    wglob(pattern, flags, results);
-	    if (!shopt_nullglob && oldlen == results->length)
-		goto quote_removal;
-	} else {
-	    /* If the pattern doesn't contain characters like L'*' and L'?',
-	     * we don't need to glob. */
+	size_t oldlen = results->length;
+	wglob(pattern, flags, results);
+	if (!shopt_nullglob && oldlen == results->length)
+	    goto quote_removal;
+    } else {
+	/* If the pattern doesn't contain characters like L'*' and L'?',
+	 * we don't need to glob. */
 quote_removal:
-	    pl_add(results, quote_removal(field, cc, ES_NONE));
-	}
-	free(field);
-	free(cc);
-	free(pattern);
+	pl_add(results, quote_removal(field, cc, ES_NONE));
     }
-    if (unblock)
-	set_interruptible_by_sigint(false);
-    pl_destroy(&e->valuelist);
-    pl_destroy(&e->cclist);
+    free(pattern);
 }
 
 
@@ -89,6 +89,10 @@ extern _Bool expand_line(
 	int *restrict argcp,
 	void ***restrict argvp)
     __attribute__((nonnull));
+typedef _Bool expand_callback_T(wchar_t *word, void *data);
+extern _Bool expand_line_each(
+	void *const *restrict args, expand_callback_T *callback, void *data)
+    __attribute__((nonnull(1,2)));
 extern _Bool expand_multiple(
 	const struct wordunit_T *restrict w, struct plist_T *restrict list)
     __attribute__((nonnull(2)));
@@ -102,6 +106,9 @@ extern wchar_t *expand_single(
 extern char *expand_single_with_glob(const struct wordunit_T *arg)
     __attribute__((malloc,warn_unused_result));
 
+extern _Bool is_plain_literal(const wchar_t *s)
+    __attribute__((nonnull,pure));
+
 extern wchar_t *extract_fields(
 	const wchar_t *restrict s, const char *restrict cc,
 	const wchar_t *restrict ifs, struct plist_T *restrict dest)
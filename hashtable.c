@@ -400,12 +400,12 @@ int keystrcoll(const void *k1, const void *k2)
     return strcoll(((const kvpair_T *) k1)->key, ((const kvpair_T *) k2)->key);
 }
 
-/* A comparison function for key-value pairs with wide-string keys.
- * The arguments are pointers to kvpair_T's (const kvpair_T *) whose keys are
- * wide strings. */
-int keywcscoll(const void *k1, const void *k2)
+/* Returns the key of a key-value pair with a wide-string key.
+ * The argument is a pointer to a kvpair_T (const kvpair_T *).
+ * Can be used as the `getkey' function to `sort_by_wcscoll'. */
+const wchar_t *keywcs(const void *kv)
 {
-    return wcscoll(((const kvpair_T *) k1)->key, ((const kvpair_T *) k2)->key);
+    return ((const kvpair_T *) kv)->key;
 }
 
 /* `Free's the key of the specified key-value pair.
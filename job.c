@@ -35,12 +35,14 @@
 #include <wctype.h>
 #include "builtin.h"
 #include "exec.h"
+#include "hashtable.h"
 #include "option.h"
 #include "plist.h"
 #include "redir.h"
 #include "sig.h"
 #include "strbuf.h"
 #include "util.h"
+#include "variable.h"
 #include "yash.h"
 #if YASH_ENABLE_LINEEDIT
 # include "xfnmatch.h"
@@ -50,11 +52,29 @@
 # endif
 #endif
 
+#if HAVE_WAIT4 && !defined(wait4)
+extern pid_t wait4(pid_t pid, int *status, int options, struct rusage *rusage);
+#endif
+
 
 static inline job_T *get_job(size_t jobnumber)
     __attribute__((pure));
 static inline void free_job(job_T *job);
+static void put_active_job(job_T *job)
+    __attribute__((nonnull));
 static void trim_joblist(void);
+static hashval_T hashpid(const void *key)
+    __attribute__((const));
+static int pidcmp(const void *key1, const void *key2)
+    __attribute__((const));
+static void index_job_pids(size_t jobnumber);
+static void unindex_job_pids(size_t jobnumber);
+static void push_free_jobnumber(size_t jobnumber);
+static size_t pop_free_jobnumber(void);
+static void set_job_status(job_T *job, jobstatus_T status)
+    __attribute__((nonnull));
+static size_t running_job_count(void)
+    __attribute__((pure));
 static void set_current_jobnumber(size_t jobnumber);
 static size_t find_next_job(size_t numlimit);
 static void apply_curstop(void);
@@ -76,14 +96,33 @@ static size_t get_jobnumber_from_name(const wchar_t *name)
 static size_t get_jobnumber_from_pid(long pid)
     __attribute__((pure));
 
+#if HAVE_WAIT4
+static void get_job_rusage(const job_T *job, struct rusage *usage)
+    __attribute__((nonnull));
+static inline void add_timeval(
+	struct timeval *restrict sum, const struct timeval *restrict tv)
+    __attribute__((nonnull));
+static int print_rusage(const struct rusage *usage, pid_t pid, FILE *f)
+    __attribute__((nonnull));
+#endif
+
 static bool jobs_builtin_print_job(size_t jobnumber,
 	bool verbose, bool changedonly, bool pgidonly,
-	bool runningonly, bool stoppedonly);
+	bool runningonly, bool stoppedonly, bool usage);
 static int continue_job(size_t jobnumber, job_T *job, bool fg)
     __attribute__((nonnull));
+static size_t get_jobnumber_from_jobspec(const wchar_t *jobspec)
+    __attribute__((nonnull));
 static int wait_for_job_by_jobspec(const wchar_t *jobspec)
     __attribute__((nonnull));
+static int report_awaited_job(size_t jobnumber);
 static bool wait_builtin_has_job(bool jobcontrol);
+static int wait_for_any_job(void *const *jobspecs, const wchar_t *varname,
+	bool jobcontrol)
+    __attribute__((nonnull(1)));
+static size_t find_awaited_job(
+	const plist_T *jobnumbers, bool jobcontrol, bool *anyjob)
+    __attribute__((nonnull));
 
 
 /* The list of jobs.
@@ -95,27 +134,108 @@ static plist_T joblist;
 /* number of the current/previous jobs. 0 if none. */
 static size_t current_jobnumber, previous_jobnumber;
 
+/* A hashtable that maps the process IDs of the processes in the job list to
+ * their job numbers, so that a process can be found without scanning the whole
+ * job list. The keys are (pid_t) values and the values are (size_t) values,
+ * both cast to (void *). Processes that were not forked (whose `pr_pid' is
+ * zero) are not indexed. If more than one job contain the same process ID,
+ * which may happen when the ID of a finished process is reused, the job added
+ * last is indexed. */
+static hashtable_T pidindex;
+
+/* A binary min-heap of unused job numbers, used to find the smallest unused
+ * number without scanning the job list. The elements are (size_t) values cast
+ * to (void *). The heap may contain numbers that are no longer unused or
+ * not less than `joblist.length', which are discarded when popped. */
+static plist_T freejobnumbers;
+
+/* A stack of jobs that have been moved out of the job list by
+ * `park_active_job'. The processes of these jobs are still waited for by
+ * `do_wait', but the jobs are not visible to the job-control built-ins. */
+static plist_T parkedjobs;
+
+/* The numbers of jobs in the job list (including the active job) in each
+ * status, indexed by `jobstatus_T'. */
+static size_t jobstatuscount[JS_DONE + 1];
+/* The number of jobs in the job list that have the `j_legacy' flag. */
+static size_t legacyjobcount;
+
+#if HAVE_WAIT4
+/* The largest `ru_maxrss' of the child processes reported by `do_wait'.
+ * The "time" keyword resets this value to measure the pipeline it executes. */
+long max_child_rss;
+#endif
+
 /* Initializes the job list. */
 void init_job(void)
 {
     assert(joblist.contents == NULL);
     pl_init(&joblist);
     pl_add(&joblist, NULL);
+    ht_init(&pidindex, hashpid, pidcmp);
+    pl_init(&freejobnumbers);
+    pl_init(&parkedjobs);
 }
 
-/* Sets the active job. */
+/* Sets the active job.
+ * The resource usage of the processes in the job is cleared. */
 void set_active_job(job_T *job)
+{
+#if HAVE_WAIT4
+    for (size_t i = 0; i < job->j_pcount; i++)
+	memset(&job->j_procs[i].pr_rusage, 0,
+		sizeof job->j_procs[i].pr_rusage);
+#endif
+    put_active_job(job);
+}
+
+/* Puts the specified job into the active job slot. */
+void put_active_job(job_T *job)
 {
     assert(ACTIVE_JOBNO < joblist.length);
     assert(joblist.contents[ACTIVE_JOBNO] == NULL);
     joblist.contents[ACTIVE_JOBNO] = job;
+    jobstatuscount[job->j_status]++;
+    if (job->j_legacy)
+	legacyjobcount++;
+    index_job_pids(ACTIVE_JOBNO);
+}
+
+/* Removes the active job from the job list without freeing it, so that the
+ * shell can execute other commands while the processes of the job are
+ * running. The processes are still waited for, but the job cannot be operated
+ * on by built-ins. The job must be put back by `unpark_job' before it is waited
+ * for. Jobs are parked and unparked in the last-in-first-out order.
+ * Returns the parked job. */
+job_T *park_active_job(void)
+{
+    job_T *job = joblist.contents[ACTIVE_JOBNO];
+
+    assert(job != NULL);
+    unindex_job_pids(ACTIVE_JOBNO);
+    jobstatuscount[job->j_status]--;
+    if (job->j_legacy)
+	legacyjobcount--;
+    joblist.contents[ACTIVE_JOBNO] = NULL;
+    pl_add(&parkedjobs, job);
+    return job;
+}
+
+/* Makes the job parked last the active job again. */
+void unpark_job(job_T *job)
+{
+    assert(parkedjobs.length > 0);
+    assert(parkedjobs.contents[parkedjobs.length - 1] == job);
+    pl_truncate(&parkedjobs, parkedjobs.length - 1);
+    put_active_job(job);
 }
 
 /* Moves the active job into the job list.
  * If the newly added job is stopped, it becomes the current job.
  * If `current' is true or there is no current job, the newly added job becomes
- * the current job if there is no stopped job. */
-void add_job(bool current)
+ * the current job if there is no stopped job.
+ * Returns the job number of the added job. */
+size_t add_job(bool current)
 {
     job_T *job = joblist.contents[ACTIVE_JOBNO];
     size_t jobnumber;
@@ -123,23 +243,23 @@ void add_job(bool current)
     assert(job != NULL);
     joblist.contents[ACTIVE_JOBNO] = NULL;
 
-    /* if there is an empty element in the list, use it */
-    for (jobnumber = 1; jobnumber < joblist.length; jobnumber++) {
-	if (joblist.contents[jobnumber] == NULL) {
-	    joblist.contents[jobnumber] = job;
-	    goto set_current;
-	}
+    /* if there is an empty element in the list, use it; otherwise, append at
+     * the end of the list */
+    jobnumber = pop_free_jobnumber();
+    if (jobnumber != 0) {
+	joblist.contents[jobnumber] = job;
+    } else {
+	jobnumber = joblist.length;
+	pl_add(&joblist, job);
     }
+    index_job_pids(jobnumber);
 
-    /* if there is no empty, append at the end of the list */
-    pl_add(&joblist, job);
-
-set_current:
     assert(joblist.contents[jobnumber] == job);
     if (job->j_status == JS_STOPPED || current)
 	set_current_jobnumber(jobnumber);
     else
 	set_current_jobnumber(current_jobnumber);
+    return jobnumber;
 }
 
 /* Returns the job of the specified number or NULL if not found. */
@@ -153,8 +273,17 @@ job_T *get_job(size_t jobnumber)
  * (another job is assigned to it). */
 void remove_job(size_t jobnumber)
 {
-    free_job(get_job(jobnumber));
-    joblist.contents[jobnumber] = NULL;
+    job_T *job = get_job(jobnumber);
+    if (job != NULL) {
+	unindex_job_pids(jobnumber);
+	jobstatuscount[job->j_status]--;
+	if (job->j_legacy)
+	    legacyjobcount--;
+	free_job(job);
+	joblist.contents[jobnumber] = NULL;
+	if (jobnumber != ACTIVE_JOBNO)
+	    push_free_jobnumber(jobnumber);
+    }
     trim_joblist();
     set_current_jobnumber(current_jobnumber);
 }
@@ -167,6 +296,11 @@ void remove_all_jobs(void)
 	joblist.contents[i] = NULL;
     }
     trim_joblist();
+    ht_clear(&pidindex, NULL);
+    pl_truncate(&freejobnumbers, 0);
+    for (size_t i = 0; i <= JS_DONE; i++)
+	jobstatuscount[i] = 0;
+    legacyjobcount = 0;
     current_jobnumber = previous_jobnumber = 0;
 }
 
@@ -195,14 +329,121 @@ void trim_joblist(void)
     }
 }
 
+/* Hashes a process ID for `pidindex'. */
+hashval_T hashpid(const void *key)
+{
+    return (hashval_T) (uintptr_t) key;
+}
+
+/* Compares two process IDs for `pidindex'. */
+int pidcmp(const void *key1, const void *key2)
+{
+    return key1 != key2;
+}
+
+/* Adds the processes of the specified job to `pidindex'. */
+void index_job_pids(size_t jobnumber)
+{
+    const job_T *job = joblist.contents[jobnumber];
+    for (size_t i = 0; i < job->j_pcount; i++) {
+	pid_t pid = job->j_procs[i].pr_pid;
+	if (pid > 0)
+	    ht_set(&pidindex, (void *) (intptr_t) pid, (void *) jobnumber);
+    }
+}
+
+/* Removes the processes of the specified job from `pidindex' unless they are
+ * indexed for another job. */
+void unindex_job_pids(size_t jobnumber)
+{
+    const job_T *job = joblist.contents[jobnumber];
+    for (size_t i = 0; i < job->j_pcount; i++) {
+	pid_t pid = job->j_procs[i].pr_pid;
+	if (pid <= 0)
+	    continue;
+	void *key = (void *) (intptr_t) pid;
+	kvpair_T kv = ht_get(&pidindex, key);
+	if (kv.key != NULL && (size_t) kv.value == jobnumber)
+	    ht_remove(&pidindex, key);
+    }
+}
+
+/* Adds the specified job number to the heap of unused job numbers. */
+void push_free_jobnumber(size_t jobnumber)
+{
+    /* The heap has only stale numbers in excess of the job list length; get
+     * rid of them by rebuilding the heap. The rebuilt heap is naturally
+     * ordered. */
+    if (freejobnumbers.length >= joblist.length) {
+	pl_truncate(&freejobnumbers, 0);
+	for (size_t i = 1; i < joblist.length; i++)
+	    if (joblist.contents[i] == NULL)
+		pl_add(&freejobnumbers, (void *) i);
+	return;
+    }
+
+    size_t i = freejobnumbers.length;
+    pl_add(&freejobnumbers, NULL);
+    while (i > 0) {
+	size_t parent = (i - 1) / 2;
+	if ((size_t) freejobnumbers.contents[parent] <= jobnumber)
+	    break;
+	freejobnumbers.contents[i] = freejobnumbers.contents[parent];
+	i = parent;
+    }
+    freejobnumbers.contents[i] = (void *) jobnumber;
+}
+
+/* Removes the smallest unused job number from the heap and returns it.
+ * Returns zero if there is no unused job number less than `joblist.length'. */
+size_t pop_free_jobnumber(void)
+{
+    while (freejobnumbers.length > 0) {
+	void **heap = freejobnumbers.contents;
+	size_t result = (size_t) heap[0];
+	size_t count = freejobnumbers.length - 1;
+	size_t last = (size_t) heap[count];
+
+	/* sift the last element down from the root */
+	size_t i = 0;
+	for (;;) {
+	    size_t child = 2 * i + 1;
+	    if (child >= count)
+		break;
+	    if (child + 1 < count && (size_t) heap[child + 1] < (size_t) heap[child])
+		child++;
+	    if (last <= (size_t) heap[child])
+		break;
+	    heap[i] = heap[child];
+	    i = child;
+	}
+	heap[i] = (void *) last;
+	pl_truncate(&freejobnumbers, count);
+
+	if (result < joblist.length && joblist.contents[result] == NULL)
+	    return result;
+    }
+    return 0;
+}
+
+/* Changes the status of the specified job in the job list. */
+void set_job_status(job_T *job, jobstatus_T status)
+{
+    jobstatuscount[job->j_status]--;
+    jobstatuscount[status]++;
+    job->j_status = status;
+}
+
 /* Sets the `j_legacy' flags of all jobs.
  * All the jobs will be no longer job-controlled. */
 void neglect_all_jobs(void)
 {
     for (size_t i = 0; i < joblist.length; i++) {
 	job_T *job = joblist.contents[i];
-	if (job != NULL)
+	if (job != NULL && !job->j_legacy) {
 	    job->j_legacy = true;
+	    legacyjobcount++;
+	}
     }
     current_jobnumber = previous_jobnumber = 0;
 }
@@ -279,6 +520,8 @@ void set_current_jobnumber(size_t jobnumber)
  * If there are more than one stopped jobs, the previous job is preferred. */
 size_t find_next_job(size_t excl)
 {
+    if (jobstatuscount[JS_STOPPED] == 0)
+	goto find_any;
     if (previous_jobnumber != excl) {
 	job_T *job = get_job(previous_jobnumber);
 	if (job != NULL && job->j_status == JS_STOPPED)
@@ -292,6 +535,7 @@ size_t find_next_job(size_t excl)
 		return jobnumber;
 	}
     }
+find_any:
     jobnumber = joblist.length;
     while (--jobnumber > 0) {
 	if (jobnumber != excl) {
@@ -318,6 +562,18 @@ void apply_curstop(void)
     set_current_jobnumber(current_jobnumber);
 }
 
+/* Returns true iff there is any job in the job list, including the active
+ * job. */
+bool any_job_exists(void)
+{
+    /* Trailing empty elements are usually removed by `trim_joblist', so we
+     * search from the end of the list. */
+    for (size_t i = joblist.length; i-- > 0; )
+	if (joblist.contents[i] != NULL)
+	    return true;
+    return false;
+}
+
 /* Counts the number of jobs in the job list. */
 size_t job_count(void)
 {
@@ -336,15 +592,44 @@ size_t job_count(void)
 /* Counts the number of stopped jobs in the job list. */
 size_t stopped_job_count(void)
 {
-    size_t count = 0;
-    for (size_t i = 0; i < joblist.length; i++) {
-	job_T *job = joblist.contents[i];
-	if (job != NULL && job->j_status == JS_STOPPED)
-	    count++;
-    }
+    return jobstatuscount[JS_STOPPED];
+}
+
+/* Counts the number of running jobs in the job list, excluding the active
+ * job. */
+size_t running_job_count(void)
+{
+    size_t count = jobstatuscount[JS_RUNNING];
+    const job_T *activejob = joblist.contents[ACTIVE_JOBNO];
+    if (activejob != NULL && activejob->j_status == JS_RUNNING)
+	count--;
     return count;
 }
 
+/* Waits until the number of running jobs gets less than the value of
+ * $YASH_JOB_SLOTS. If the variable is not set or its value is not a positive
+ * integer, this function returns immediately.
+ * Traps are handled while waiting. If the shell is interactive, waiting can be
+ * canceled by SIGINT, in which case the signal number is returned. Otherwise,
+ * returns zero. */
+int wait_for_job_slot(void)
+{
+    const wchar_t *v = getvar(L VAR_YASH_JOB_SLOTS);
+    if (v == NULL)
+	return 0;
+
+    int slots;
+    if (!xwcstoi(v, 10, &slots) || slots <= 0)
+	return 0;
+
+    while (running_job_count() >= (size_t) slots) {
+	wait_for_sigchld(is_interactive_now, true);
+	if (is_interrupted())
+	    return SIGINT;
+    }
+    return 0;
+}
+
 
 /* Updates the info about the jobs in the job list.
  * This function doesn't block. */
@@ -352,6 +637,9 @@ void do_wait(void)
 {
     pid_t pid;
     int status;
+#if HAVE_WAIT4
+    struct rusage usage;
+#endif
 #if HAVE_WCONTINUED
     static int waitpidoption = WUNTRACED | WCONTINUED | WNOHANG;
 #else
@@ -359,7 +647,11 @@ void do_wait(void)
 #endif
 
 start:
+#if HAVE_WAIT4
+    pid = wait4(-1, &status, waitpidoption, &usage);
+#else
     pid = waitpid(-1, &status, waitpidoption);
+#endif
     if (pid < 0) {
 	switch (errno) {
 	    case EINTR:
@@ -389,8 +681,27 @@ start:
     size_t jobnumber, pnumber;
     job_T *job;
     process_T *pr;
+    bool parked = false;
 
     /* determine `jobnumber', `job' and `pr' from `pid' */
+    kvpair_T kv = ht_get(&pidindex, (void *) (intptr_t) pid);
+    if (kv.key != NULL) {
+	jobnumber = (size_t) kv.value;
+	job = joblist.contents[jobnumber];
+	for (pnumber = 0; pnumber < job->j_pcount; pnumber++)
+	    if ((pr = &job->j_procs[pnumber])->pr_pid == pid &&
+		    pr->pr_status != JS_DONE)
+		goto found;
+    }
+    for (size_t i = parkedjobs.length; i-- > 0; ) {
+	job = parkedjobs.contents[i];
+	for (pnumber = 0; pnumber < job->j_pcount; pnumber++)
+	    if ((pr = &job->j_procs[pnumber])->pr_pid == pid &&
+		    pr->pr_status != JS_DONE) {
+		parked = true;
+		goto found;
+	    }
+    }
     for (jobnumber = 0; jobnumber < joblist.length; jobnumber++)
 	if ((job = joblist.contents[jobnumber]) != NULL)
 	    for (pnumber = 0; pnumber < job->j_pcount; pnumber++)
@@ -404,6 +715,11 @@ start:
 
 found:
     pr->pr_statuscode = status;
+#if HAVE_WAIT4
+    pr->pr_rusage = usage;
+    if (max_child_rss < usage.ru_maxrss)
+	max_child_rss = usage.ru_maxrss;
+#endif
     if (WIFEXITED(status) || WIFSIGNALED(status))
 	pr->pr_status = JS_DONE;
     if (WIFSTOPPED(status))
@@ -429,8 +745,13 @@ found:
 	    default:                              break;
 	}
     }
-out_of_loop:
-    job->j_status = anyrunning ? JS_RUNNING : anystopped ? JS_STOPPED : JS_DONE;
+out_of_loop:;
+    jobstatus_T newstatus =
+	    anyrunning ? JS_RUNNING : anystopped ? JS_STOPPED : JS_DONE;
+    if (parked)
+	job->j_status = newstatus;  /* parked jobs are not counted */
+    else
+	set_job_status(job, newstatus);
     if (job->j_status != oldstatus)
 	job->j_statuschanged = true;
 
@@ -506,6 +827,9 @@ wchar_t **wait_for_child(pid_t cpid, pid_t cpgid, bool return_on_stop)
     if (doing_job_control_now)
 	put_foreground(shell_pgid);
     laststatus = calc_status_of_job(job);
+#if HAVE_WAIT4
+    set_rusage_variable(job);
+#endif
     if (job->j_status == JS_DONE) {
 	notify_signaled_job(ACTIVE_JOBNO);
 	remove_job(ACTIVE_JOBNO);
@@ -621,6 +945,90 @@ int calc_status_of_process(const process_T *p)
     return (p->pr_pid == 0) ? s : calc_status(s);
 }
 
+#if HAVE_WAIT4
+
+/* Computes the resource usage of the whole job. The CPU times and block counts
+ * of the processes are summed up and the maximum resident set size is the
+ * largest of those of the processes. Processes that have not been reported by
+ * `wait4' count as zero. */
+void get_job_rusage(const job_T *job, struct rusage *usage)
+{
+    memset(usage, 0, sizeof *usage);
+    for (size_t i = 0; i < job->j_pcount; i++) {
+	const struct rusage *ru = &job->j_procs[i].pr_rusage;
+	add_timeval(&usage->ru_utime, &ru->ru_utime);
+	add_timeval(&usage->ru_stime, &ru->ru_stime);
+	if (usage->ru_maxrss < ru->ru_maxrss)
+	    usage->ru_maxrss = ru->ru_maxrss;
+	usage->ru_inblock += ru->ru_inblock;
+	usage->ru_oublock += ru->ru_oublock;
+    }
+}
+
+/* Adds `tv' to `sum'. */
+void add_timeval(struct timeval *restrict sum, const struct timeval *restrict tv)
+{
+    sum->tv_sec += tv->tv_sec;
+    sum->tv_usec += tv->tv_usec;
+    if (sum->tv_usec >= 1000000) {
+	sum->tv_sec++;
+	sum->tv_usec -= 1000000;
+    }
+}
+
+/* Sets the $YASH_RUSAGE array to the resource usage of the specified job.
+ * The elements are the user and system CPU times in seconds, the maximum
+ * resident set size, and the numbers of blocks read and written.
+ * The array is silently left unchanged if it is read-only. */
+void set_rusage_variable(const job_T *job)
+{
+    if (is_readonly_variable(L VAR_YASH_RUSAGE))
+	return;
+
+    struct rusage usage;
+    get_job_rusage(job, &usage);
+
+    void **values = xmallocn(6, sizeof *values);
+    values[0] = malloc_wprintf(L"%jd.%03ld",
+	    (intmax_t) usage.ru_utime.tv_sec,
+	    (long) usage.ru_utime.tv_usec / 1000);
+    values[1] = malloc_wprintf(L"%jd.%03ld",
+	    (intmax_t) usage.ru_stime.tv_sec,
+	    (long) usage.ru_stime.tv_usec / 1000);
+    values[2] = malloc_wprintf(L"%ld", (long) usage.ru_maxrss);
+    values[3] = malloc_wprintf(L"%ld", (long) usage.ru_inblock);
+    values[4] = malloc_wprintf(L"%ld", (long) usage.ru_oublock);
+    values[5] = NULL;
+    set_array(L VAR_YASH_RUSAGE, 5, values, SCOPE_GLOBAL, false);
+}
+
+/* Prints the resource usage in a line. If `pid' is positive, it is printed
+ * at the beginning of the line.
+ * Returns zero if successful. Returns errno if `fprintf' failed. */
+int print_rusage(const struct rusage *usage, pid_t pid, FILE *f)
+{
+    int result;
+    if (pid > 0)
+	result = fprintf(f, "      %5jd ", (intmax_t) pid);
+    else
+	result = fprintf(f, "      ");
+    if (result < 0)
+	return errno;
+
+    result = fprintf(f, gt("user %jd.%03lds  system %jd.%03lds  "
+		"max RSS %ld  blocks in %ld  blocks out %ld\n"),
+	    (intmax_t) usage->ru_utime.tv_sec,
+	    (long) usage->ru_utime.tv_usec / 1000,
+	    (intmax_t) usage->ru_stime.tv_sec,
+	    (long) usage->ru_stime.tv_usec / 1000,
+	    (long) usage->ru_maxrss,
+	    (long) usage->ru_inblock,
+	    (long) usage->ru_oublock);
+    return (result >= 0) ? 0 : errno;
+}
+
+#endif /* HAVE_WAIT4 */
+
 /* Computes the exit status of the specified job.
  * The job state must be JS_DONE or JS_STOPPED. */
 int calc_status_of_job(const job_T *job)
@@ -927,8 +1335,13 @@ size_t get_jobnumber_from_name(const wchar_t *name)
 size_t get_jobnumber_from_pid(long pid)
 {
     size_t jobnumber;
-    if (pid == 0)
+    if (pid <= 0)
 	return 0;
+
+    kvpair_T kv = ht_get(&pidindex, (void *) (intptr_t) pid);
+    if (kv.key != NULL && (size_t) kv.value != ACTIVE_JOBNO)
+	return (size_t) kv.value;
+
     for (jobnumber = joblist.length; --jobnumber > 0; ) {
 	job_T *job = joblist.contents[jobnumber];
 	if (job != NULL) {
@@ -995,6 +1408,9 @@ const struct xgetopt_T jobs_options[] = {
     { L'p', L"pgid-only",    OPTARG_NONE, true,  NULL, },
     { L'r', L"running-only", OPTARG_NONE, false, NULL, },
     { L's', L"stopped-only", OPTARG_NONE, false, NULL, },
+#if HAVE_WAIT4
+    { L'u', L"usage",        OPTARG_NONE, false, NULL, },
+#endif
 #if YASH_ENABLE_HELP
     { L'-', L"help",         OPTARG_NONE, false, NULL, },
 #endif
@@ -1007,11 +1423,12 @@ const struct xgetopt_T jobs_options[] = {
  *  -p: print the process ID only
  *  -r: print running jobs only
  *  -s: print stopped jobs only
+ *  -u: print resource usage of finished processes
  * In the POSIXly correct mode, only -l and -p are available. */
 int jobs_builtin(int argc, void **argv)
 {
     bool verbose = false, changedonly = false, pgidonly = false;
-    bool runningonly = false, stoppedonly = false;
+    bool runningonly = false, stoppedonly = false, usage = false;
 
     const struct xgetopt_T *opt;
     xoptind = 0;
@@ -1022,6 +1439,9 @@ int jobs_builtin(int argc, void **argv)
 	    case L'p':  pgidonly    = true;  break;
 	    case L'r':  runningonly = true;  break;
 	    case L's':  stoppedonly = true;  break;
+#if HAVE_WAIT4
+	    case L'u':  usage       = true;  break;
+#endif
 #if YASH_ENABLE_HELP
 	    case L'-':
 		return print_builtin_help(ARGV(0));
@@ -1054,7 +1474,7 @@ int jobs_builtin(int argc, void **argv)
 		xerror(0, Ngt("no such job `%ls'"), ARGV(xoptind));
 	    } else {
 		if (!jobs_builtin_print_job(jobnumber, verbose,
-			changedonly, pgidonly, runningonly, stoppedonly))
+			changedonly, pgidonly, runningonly, stoppedonly, usage))
 		    return Exit_FAILURE;
 	    }
 	} while (++xoptind < argc);
@@ -1062,7 +1482,7 @@ int jobs_builtin(int argc, void **argv)
 	/* print all jobs */
 	for (size_t i = 1; i < joblist.length; i++) {
 	    if (!jobs_builtin_print_job(i, verbose, changedonly, pgidonly,
-		    runningonly, stoppedonly))
+		    runningonly, stoppedonly, usage))
 		return Exit_FAILURE;
 	}
     }
@@ -1075,7 +1495,8 @@ int jobs_builtin(int argc, void **argv)
  * is returned. */
 bool jobs_builtin_print_job(size_t jobnumber,
 	bool verbose, bool changedonly, bool pgidonly,
-	bool runningonly, bool stoppedonly)
+	bool runningonly, bool stoppedonly,
+	bool usage __attribute__((unused)))
 {
     job_T *job = get_job(jobnumber);
 
@@ -1092,6 +1513,24 @@ bool jobs_builtin_print_job(size_t jobnumber,
 	    return true;
 	int result = printf("%jd\n", (intmax_t) job->j_pgid);
 	err = (result >= 0) ? 0 : errno;
+#if HAVE_WAIT4
+    } else if (usage) {
+	if (job->j_nonotify || (changedonly && !job->j_statuschanged))
+	    return true;
+	err = print_job_status(jobnumber, false, verbose, false, stdout);
+	if (verbose) {
+	    for (size_t i = 0; err == 0 && i < job->j_pcount; i++)
+		if (job->j_procs[i].pr_pid != 0)
+		    err = print_rusage(&job->j_procs[i].pr_rusage,
+			    job->j_procs[i].pr_pid, stdout);
+	} else if (err == 0) {
+	    struct rusage jobusage;
+	    get_job_rusage(job, &jobusage);
+	    err = print_rusage(&jobusage, 0, stdout);
+	}
+	if (job->j_status == JS_DONE)
+	    remove_job(jobnumber);
+#endif
     } else {
 	err = print_job_status(jobnumber, changedonly, verbose, true, stdout);
     }
@@ -1108,7 +1547,11 @@ const char jobs_help[] = Ngt(
 "print info about jobs"
 );
 const char jobs_syntax[] = Ngt(
+#if HAVE_WAIT4
+"\tjobs [-lnprsu] [job...]\n"
+#else
 "\tjobs [-lnprs] [job...]\n"
+#endif
 );
 #endif
 
@@ -1208,7 +1651,7 @@ int continue_job(size_t jobnumber, job_T *job, bool fg)
 	if (fg)
 	    put_foreground(job->j_pgid);
 	if (kill(-job->j_pgid, SIGCONT) >= 0)
-	    job->j_status = JS_RUNNING;
+	    set_job_status(job, JS_RUNNING);
     } else {
 	if (!fg)
 	    xerror(0, Ngt("job %%%zu has already terminated"), jobnumber);
@@ -1272,16 +1715,41 @@ const char bg_syntax[] = Ngt(
 
 #endif /* YASH_ENABLE_HELP */
 
-/* The "wait" built-in */
+/* Options for the "wait" built-in. */
+const struct xgetopt_T wait_options[] = {
+    { L'n', L"next",         OPTARG_NONE,     false, NULL, },
+    { L'p', L"pid-variable", OPTARG_REQUIRED, false, NULL, },
+#if YASH_ENABLE_HELP
+    { L'-', L"help",         OPTARG_NONE,     false, NULL, },
+#endif
+    { L'\0', NULL, 0, false, NULL, },
+};
+
+/* The "wait" built-in, which accepts the following options:
+ *  -n: wait for any one of the jobs to finish
+ *  -p var: assign the process ID of the job awaited by -n to variable `var' */
 int wait_builtin(int argc, void **argv)
 {
     bool jobcontrol = doing_job_control_now;
+    bool next = false;
+    const wchar_t *varname = NULL;
     int status = Exit_SUCCESS;
 
     const struct xgetopt_T *opt;
     xoptind = 0;
-    while ((opt = xgetopt(argv, help_option, 0)) != NULL) {
+    while ((opt = xgetopt(argv, wait_options, 0)) != NULL) {
 	switch (opt->shortopt) {
+	    case L'n':
+		next = true;
+		break;
+	    case L'p':
+		varname = xoptarg;
+		if (wcschr(varname, L'=')) {
+		    xerror(0, Ngt("`%ls' is not a valid variable name"),
+			    varname);
+		    return Exit_FAILURE;
+		}
+		break;
 #if YASH_ENABLE_HELP
 	    case L'-':
 		return print_builtin_help(ARGV(0));
@@ -1291,7 +1759,9 @@ int wait_builtin(int argc, void **argv)
 	}
     }
 
-    if (xoptind < argc) {
+    if (next) {
+	status = wait_for_any_job(&argv[xoptind], varname, jobcontrol);
+    } else if (xoptind < argc) {
 	/* wait for the specified jobs */
 	for (; xoptind < argc; xoptind++) {
 	    int jobstatus = wait_for_job_by_jobspec(ARGV(xoptind));
@@ -1318,9 +1788,11 @@ int wait_builtin(int argc, void **argv)
     return status;
 }
 
-/* Finds a job specified by the argument and waits for it.
- * Returns a negated exit status if interrupted. */
-int wait_for_job_by_jobspec(const wchar_t *jobspec)
+/* Returns the number of the job specified by the argument for the "wait"
+ * built-in. The argument may be a job ID or a process ID.
+ * Returns zero if there is no such job that can be awaited.
+ * On error, an error message is printed and `SIZE_MAX' is returned. */
+size_t get_jobnumber_from_jobspec(const wchar_t *jobspec)
 {
     size_t jobnumber;
     if (jobspec[0] == L'%') {
@@ -1329,19 +1801,29 @@ int wait_for_job_by_jobspec(const wchar_t *jobspec)
 	long pid;
 	if (!xwcstol(jobspec, 10, &pid) || pid < 0) {
 	    xerror(0, Ngt("`%ls' is not a valid job specification"), jobspec);
-	    return Exit_FAILURE;
+	    return SIZE_MAX;
 	}
 	jobnumber = get_jobnumber_from_pid(pid);
     }
     if (jobnumber >= joblist.length) {
 	xerror(0, Ngt("job specification `%ls' is ambiguous"), jobspec);
-	return Exit_FAILURE;
+	return SIZE_MAX;
     }
 
-    job_T *job;
-    if (jobnumber == 0
-	    || (job = joblist.contents[jobnumber]) == NULL
-	    || job->j_legacy)
+    job_T *job = joblist.contents[jobnumber];
+    if (job == NULL || job->j_legacy)
+	return 0;
+    return jobnumber;
+}
+
+/* Finds a job specified by the argument and waits for it.
+ * Returns a negated exit status if interrupted. */
+int wait_for_job_by_jobspec(const wchar_t *jobspec)
+{
+    size_t jobnumber = get_jobnumber_from_jobspec(jobspec);
+    if (jobnumber == SIZE_MAX)
+	return Exit_FAILURE;
+    if (jobnumber == 0)
 	return Exit_NOTFOUND;
 
     int signal = wait_for_job(jobnumber,
@@ -1351,6 +1833,15 @@ int wait_for_job_by_jobspec(const wchar_t *jobspec)
 	return -(signal + TERMSIGOFFSET);
     }
 
+    return report_awaited_job(jobnumber);
+}
+
+/* Returns the exit status of the specified job that has been awaited by the
+ * "wait" built-in. If the job has finished or stopped, it is printed or
+ * removed from the job list. */
+int report_awaited_job(size_t jobnumber)
+{
+    const job_T *job = joblist.contents[jobnumber];
     int status = calc_status_of_job(job);
     if (job->j_status != JS_RUNNING) {
 	if (doing_job_control_now && is_interactive_now && !posixly_correct)
@@ -1365,21 +1856,111 @@ int wait_for_job_by_jobspec(const wchar_t *jobspec)
 bool wait_builtin_has_job(bool jobcontrol)
 {
     /* print/remove already-finished jobs */
-    for (size_t i = 1; i < joblist.length; i++) {
-	job_T *job = joblist.contents[i];
-	if (jobcontrol && is_interactive_now && !posixly_correct)
-	    print_job_status(i, true, false, false, stdout);
-	if (job != NULL && (job->j_legacy || job->j_status == JS_DONE))
-	    remove_job(i);
+    bool print = jobcontrol && is_interactive_now && !posixly_correct;
+    if (print || jobstatuscount[JS_DONE] > 0 || legacyjobcount > 0) {
+	for (size_t i = 1; i < joblist.length; i++) {
+	    job_T *job = joblist.contents[i];
+	    if (print)
+		print_job_status(i, true, false, false, stdout);
+	    if (job != NULL && (job->j_legacy || job->j_status == JS_DONE))
+		remove_job(i);
+	}
     }
 
     /* see if we have jobs to wait for. */
-    for (size_t i = 1; i < joblist.length; i++) {
-	job_T *job = joblist.contents[i];
-	if (job != NULL && (!jobcontrol || job->j_status == JS_RUNNING))
-	    return true;
+    size_t count = running_job_count();
+    if (!jobcontrol) {
+	const job_T *activejob = joblist.contents[ACTIVE_JOBNO];
+	count += jobstatuscount[JS_STOPPED];
+	if (activejob != NULL && activejob->j_status == JS_STOPPED)
+	    count--;
     }
-    return false;
+    return count > 0;
+}
+
+/* Waits for any one of the specified jobs to finish (or stop if job control is
+ * active). If no jobs are specified, any job in the job list is awaited. The
+ * job that finished first is printed or removed as in `report_awaited_job' and
+ * the process ID of its last process is assigned to variable `varname' unless
+ * it is NULL. Returns the exit status of the job, or Exit_NOTFOUND if there is
+ * no job to wait for. */
+int wait_for_any_job(void *const *jobspecs, const wchar_t *varname,
+	bool jobcontrol)
+{
+    plist_T jobnumbers;
+    pl_init(&jobnumbers);
+    if (*jobspecs != NULL) {
+	for (; *jobspecs != NULL; jobspecs++) {
+	    size_t jobnumber = get_jobnumber_from_jobspec(*jobspecs);
+	    if (jobnumber == SIZE_MAX) {
+		pl_destroy(&jobnumbers);
+		return Exit_FAILURE;
+	    }
+	    if (jobnumber != 0)
+		pl_add(&jobnumbers, (void *) jobnumber);
+	}
+	if (jobnumbers.length == 0) {
+	    pl_destroy(&jobnumbers);
+	    return Exit_NOTFOUND;
+	}
+    }
+
+    int status;
+    for (;;) {
+	bool anyjob;
+	size_t jobnumber = find_awaited_job(&jobnumbers, jobcontrol, &anyjob);
+	if (jobnumber != 0) {
+	    if (varname != NULL) {
+		const job_T *job = joblist.contents[jobnumber];
+		pid_t pid = job->j_procs[job->j_pcount - 1].pr_pid;
+		if (!set_variable(varname,
+			    malloc_wprintf(L"%jd", (intmax_t) pid),
+			    SCOPE_GLOBAL, shopt_allexport)) {
+		    status = Exit_FAILURE;
+		    break;
+		}
+	    }
+	    status = report_awaited_job(jobnumber);
+	    break;
+	}
+	if (!anyjob) {
+	    status = Exit_NOTFOUND;
+	    break;
+	}
+
+	status = wait_for_sigchld(jobcontrol, true);
+	if (status != 0) {
+	    assert(TERMSIGOFFSET >= 128);
+	    status += TERMSIGOFFSET;
+	    break;
+	}
+    }
+    pl_destroy(&jobnumbers);
+    return status;
+}
+
+/* Returns the number of a job that has finished (or stopped if `jobcontrol' is
+ * true) among the jobs in `jobnumbers', or among all the jobs in the job list
+ * if `jobnumbers' is empty. Returns zero if no such job is found, in which case
+ * `*anyjob' is set to indicate whether there is any job to wait for. */
+size_t find_awaited_job(
+	const plist_T *jobnumbers, bool jobcontrol, bool *anyjob)
+{
+    size_t count = (jobnumbers->length > 0) ? jobnumbers->length
+	    : (joblist.length > 0) ? joblist.length - 1 : 0;
+    *anyjob = false;
+    for (size_t i = 0; i < count; i++) {
+	size_t jobnumber = (jobnumbers->length > 0)
+		? (size_t) jobnumbers->contents[i] : i + 1;
+	const job_T *job = get_job(jobnumber);
+	if (job == NULL || job->j_legacy)
+	    continue;
+	if (job->j_status == JS_DONE
+		|| (jobcontrol && job->j_status == JS_STOPPED))
+	    return jobnumber;
+	*anyjob = true;
+    }
+    return 0;
 }
 
 #if YASH_ENABLE_HELP
@@ -1388,6 +1969,7 @@ const char wait_help[] = Ngt(
 );
 const char wait_syntax[] = Ngt(
 "\twait [job or process_id...]\n"
+"\twait -n [-p variable] [job or process_id...]\n"
 );
 #endif
 
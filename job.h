@@ -20,6 +20,9 @@
 #define YASH_JOB_H
 
 #include <stddef.h>
+#if HAVE_WAIT4
+# include <sys/resource.h>
+#endif
 #include <sys/types.h>
 #include "xgetopt.h"
 
@@ -34,12 +37,17 @@ typedef struct process_T {
     pid_t        pr_pid;          /* process ID */
     jobstatus_T  pr_status;
     int          pr_statuscode;
+#if HAVE_WAIT4
+    struct rusage pr_rusage;      /* resource usage reported by `wait4' */
+#endif
     wchar_t     *pr_name;         /* process name made from command line */
 } process_T;
 /* If `pr_pid' is 0, the process was finished without `fork'ing from the shell.
  * In this case, `pr_status' is JS_DONE and `pr_statuscode' is the exit status.
  * If `pr_pid' is a positive number, it's the process ID. In this case,
- * `pr_statuscode' is the status code returned by `waitpid'. */
+ * `pr_statuscode' is the status code returned by `waitpid'.
+ * `pr_rusage' is cleared when the job is set active and updated each time the
+ * status of the process is reported. */
 
 /* info about a job */
 typedef struct job_T {
@@ -67,19 +75,29 @@ typedef struct job_T {
 #define TERMSIGOFFSET 384
 #endif
 
+#if HAVE_WAIT4
+extern long max_child_rss;
+#endif
+
 extern void init_job(void);
 
 extern void set_active_job(job_T *job)
     __attribute__((nonnull));
-extern void add_job(_Bool current);
+extern job_T *park_active_job(void);
+extern void unpark_job(job_T *job)
+    __attribute__((nonnull));
+extern size_t add_job(_Bool current);
 extern void remove_job(size_t jobnumber);
 extern void remove_job_nofitying_signal(size_t jobnumber);
 extern void remove_all_jobs(void);
 extern void neglect_all_jobs(void);
+extern _Bool any_job_exists(void)
+    __attribute__((pure));
 extern size_t job_count(void)
     __attribute__((pure));
 extern size_t stopped_job_count(void)
     __attribute__((pure));
+extern int wait_for_job_slot(void);
 
 extern void do_wait(void);
 extern int wait_for_job(size_t jobnumber, _Bool return_on_stop,
@@ -93,6 +111,10 @@ extern void ensure_foreground(void);
 
 extern int calc_status_of_job(const job_T *job)
     __attribute__((pure,nonnull));
+#if HAVE_WAIT4
+extern void set_rusage_variable(const job_T *job)
+    __attribute__((nonnull));
+#endif
 
 extern _Bool any_job_status_has_changed(void)
     __attribute__((pure));
@@ -117,6 +139,7 @@ extern int wait_builtin(int argc, void **argv)
 #if YASH_ENABLE_HELP
 extern const char wait_help[], wait_syntax[];
 #endif
+extern const struct xgetopt_T wait_options[];
 
 extern int disown_builtin(int argc, void **argv)
     __attribute__((nonnull));
@@ -112,8 +112,8 @@ static void free_candidate(void *c)
     __attribute__((nonnull));
 static void free_context(le_context_T *ctxt);
 static void sort_candidates(void);
-static int sort_candidates_cmp(const void *cp1, const void *cp2)
-    __attribute__((nonnull));
+static int sort_candidates_cmp(const void *p1, const void *p2)
+    __attribute__((pure,nonnull));
 static void print_context_info(const le_context_T *ctxt)
     __attribute__((nonnull));
 static void print_compopt_info(const le_compopt_T *compopt)
@@ -414,51 +414,78 @@ void free_context(le_context_T *ctxt)
     }
 }
 
-/* Sorts the candidates in the candidate list and removes duplicates. */
+/* An element of the array sorted in `sort_candidates' */
+struct candsortitem_T {
+    le_candidate_T *cand;
+    const wchar_t *rest;  // `cand->origvalue' without leading hyphens
+    size_t hyphens;       // number of leading hyphens in `cand->origvalue'
+    const wchar_t *key;   // collation key of `rest'
+};
+
+/* Sorts the candidates in the candidate list and removes duplicates.
+ * The collation key of each candidate is computed once before sorting so that
+ * comparison does not need `wcscoll'. */
 void sort_candidates(void)
 {
-    qsort(le_candidates.contents,
-	    le_candidates.length, sizeof *le_candidates.contents,
-	    sort_candidates_cmp);
-
-    if (le_candidates.length >= 2) {
-	for (size_t i = le_candidates.length - 1; i > 0; i--) {
-	    le_candidate_T *cand1 = le_candidates.contents[i];
-	    le_candidate_T *cand2 = le_candidates.contents[i - 1];
-	    // XXX case-sensitive
-	    if (wcscoll(cand1->origvalue, cand2->origvalue) == 0) {
-		free_candidate(cand1);
-		pl_remove(&le_candidates, i, 1);
-	    }
-	}
+    size_t count = le_candidates.length;
+    if (count == 0)
+	return;
+
+    struct candsortitem_T *items = xmallocn(count, sizeof *items);
+    size_t *offsets = xmallocn(count, sizeof *offsets);
+    xwcsbuf_T keys;
+    wb_init(&keys);
+    for (size_t i = 0; i < count; i++) {
+	le_candidate_T *cand = le_candidates.contents[i];
+	const wchar_t *rest = cand->origvalue;
+	while (*rest == L'-')
+	    rest++;
+	items[i].cand = cand;
+	items[i].rest = rest;
+	items[i].hyphens = rest - cand->origvalue;
+	offsets[i] = keys.length;
+	wb_wcsxfrmcat(&keys, rest);
+	wb_wccat(&keys, L'\0');
     }
+    for (size_t i = 0; i < count; i++)
+	items[i].key = &keys.contents[offsets[i]];
+    free(offsets);
+
+    qsort(items, count, sizeof *items, sort_candidates_cmp);
+
+    pl_truncate(&le_candidates, 0);
+    for (size_t i = 0; i < count; i++) {
+	// XXX case-sensitive
+	if (i > 0 && items[i].hyphens == items[i - 1].hyphens
+		&& wcscmp(items[i].key, items[i - 1].key) == 0)
+	    free_candidate(items[i].cand);
+	else
+	    pl_add(&le_candidates, items[i].cand);
+    }
+
+    wb_destroy(&keys);
+    free(items);
 }
 
-int sort_candidates_cmp(const void *cp1, const void *cp2)
+/* Candidates that start with hyphens are sorted in a special order so that
+ * short options come before long options: candidates are first ordered by the
+ * number of leading hyphens, and those that start with hyphens are sorted
+ * case-insensitively. */
+int sort_candidates_cmp(const void *p1, const void *p2)
 {
-    const le_candidate_T *cand1 = *(const le_candidate_T **) cp1;
-    const le_candidate_T *cand2 = *(const le_candidate_T **) cp2;
-    const wchar_t *v1 = cand1->origvalue;
-    const wchar_t *v2 = cand2->origvalue;
-
-    /* Candidates that start with hyphens are sorted in a special order so that
-     * short options come before long options. Such candidates are sorted case-
-     * insensitively. */
-    if (v1[0] == L'-' || v2[0] == L'-') {
-	while (*v1 == L'-' && *v2 == L'-')
-	    v1++, v2++;
-	if (*v1 == L'-')
-	    return 1;
-	if (*v2 == L'-')
-	    return -1;
+    const struct candsortitem_T *item1 = p1, *item2 = p2;
+
+    if (item1->hyphens != item2->hyphens)
+	return (item1->hyphens > item2->hyphens) ? 1 : -1;
 #if HAVE_WCSCASECMP
-	int cmp = wcscasecmp(v1, v2);
+    if (item1->hyphens > 0) {
+	int cmp = wcscasecmp(item1->rest, item2->rest);
 	if (cmp != 0)
 	    return cmp;
-#endif
     }
+#endif
 
-    return wcscoll(v1, v2);
+    return wcscmp(item1->key, item2->key);
     // XXX case-sensitive
 }
 
@@ -627,6 +627,7 @@ cparse_word:
 	wordunit_T *w = xmalloc(sizeof *w);                            \
 	w->next = NULL;                                                \
 	w->wu_type = WT_STRING;                                        \
+	w->wu_plain = false;                                           \
 	w->wu_string = xwcsndup(&BUF[startindex], INDEX - startindex); \
 	*lastp = w, lastp = &w->next;                                  \
     } while (0)
@@ -710,6 +711,7 @@ end_single_quote:;
     wordunit_T *w = xmalloc(sizeof *w);
     w->next = NULL;
     w->wu_type = WT_STRING;
+    w->wu_plain = false;
     w->wu_string = malloc_wprintf(L"%ls'", &BUF[startindex]);
     *lastp = w, lastp = &w->next;
 
@@ -828,6 +830,7 @@ wordunit_T *cparse_paramexp_raw(le_contexttype_T ctxttype)
     wu->next = NULL;
     if (namelen == 0) {
 	wu->wu_type = WT_STRING;
+	wu->wu_plain = false;
 	wu->wu_string = xwcsdup(L"$");
     } else {
 	wu->wu_type = WT_PARAM;
@@ -1055,6 +1058,7 @@ syntax_error:
     result = xmalloc(sizeof *result);
     result->next = NULL;
     result->wu_type = WT_STRING;
+    result->wu_plain = false;
     result->wu_string = escapefree(
 	    xwcsndup(&BUF[origindex], INDEX - origindex), NULL);
     return result;
@@ -1103,6 +1107,7 @@ return_content:;
     wordunit_T *result = xmalloc(sizeof *result);
     result->next = NULL;
     result->wu_type = WT_STRING;
+    result->wu_plain = false;
     result->wu_string = xwcsndup(&BUF[startindex], INDEX - startindex);
     return result;
 }
@@ -1127,6 +1132,7 @@ wordunit_T *cparse_cmdsubst_in_paren(void)
 	wordunit_T *result = xmalloc(sizeof *result);
 	result->next = NULL;
 	result->wu_type = WT_STRING;
+	result->wu_plain = false;
 	result->wu_string = xwcsndup(&BUF[startindex], INDEX - startindex);
 	return result;
     }
@@ -1166,6 +1172,7 @@ return_content:
     wordunit_T *result = xmalloc(sizeof *result);
     result->next = NULL;
     result->wu_type = WT_STRING;
+    result->wu_plain = false;
     result->wu_string =
 	escapefree(xwcsndup(&BUF[startindex], endindex - startindex), NULL);
     return result;
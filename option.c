@@ -103,6 +103,9 @@ bool shopt_errreturn = false;
  * defines the exit status of the whole pipeline. Corresponds to the --pipefail
  * option. */
 bool shopt_pipefail = false;
+/* If set, the last command of a pipeline is executed in the shell process when
+ * job control is not active. Corresponds to the --lastpipe option. */
+bool shopt_lastpipe = false;
 /* If set, undefined variables are expanded to an empty string.
  * Corresponds to the +u/--unset option. */
 bool shopt_unset = true;
@@ -155,6 +158,13 @@ bool shopt_extendedglob = false;
  * intact when there are no matches for it.
  * Corresponds to the --nullglob option. */
 bool shopt_nullglob = false;
+/* If set, pathname expansion in the for loop is performed while the loop is
+ * running and the results are not sorted.
+ * Corresponds to the --forlazyglob option. */
+bool shopt_forlazyglob = false;
+/* If set, directories are read in parallel in recursive pathname expansion.
+ * Corresponds to the --parallelglob option. */
+bool shopt_parallelglob = false;
 
 /* If set, brace expansion is enabled.
  * Corresponds to the --braceexpand option. */
@@ -225,6 +235,7 @@ static const struct option_T shell_options[] = {
     { 0,    0,    L"errreturn",      &shopt_errreturn,      true, },
     { 0,    L'n', L"exec",           &shopt_exec,           true, },
     { 0,    0,    L"extendedglob",   &shopt_extendedglob,   true, },
+    { 0,    0,    L"forlazyglob",    &shopt_forlazyglob,    true, },
     { 0,    0,    L"forlocal",       &shopt_forlocal,       true, },
     { 0,    L'f', L"glob",           &shopt_glob,           true, },
     { L'h', 0,    L"hashondef",      &shopt_hashondef,      true, },
@@ -233,6 +244,7 @@ static const struct option_T shell_options[] = {
 #endif
     { 0,    0,    L"ignoreeof",      &shopt_ignoreeof,      true, },
     { L'i', 0,    L"interactive",    &is_interactive,       false, },
+    { 0,    0,    L"lastpipe",       &shopt_lastpipe,       true, },
 #if YASH_ENABLE_LINEEDIT
     { 0,    0,    L"lealwaysrp",     &shopt_le_alwaysrp,    true, },
     { 0,    0,    L"lecompdebug",    &shopt_le_compdebug,   true, },
@@ -252,6 +264,7 @@ static const struct option_T shell_options[] = {
     { 0,    0,    L"notifyle",       &shopt_notifyle,       true, },
 #endif
     { 0,    0,    L"nullglob",       &shopt_nullglob,       true, },
+    { 0,    0,    L"parallelglob",   &shopt_parallelglob,   true, },
     { 0,    0,    L"pipefail",       &shopt_pipefail,       true, },
     { 0,    0,    L"posixlycorrect", &posixly_correct,      true, },
     { L's', 0,    L"stdin",          &shopt_stdin,          false, },
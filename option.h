@@ -42,14 +42,15 @@ extern _Bool shopt_cmdline, shopt_stdin;
 extern _Bool do_job_control, shopt_notify, shopt_notifyle,
        shopt_curasync, shopt_curbg, shopt_curstop;
 extern _Bool shopt_allexport, shopt_hashondef, shopt_forlocal;
-extern _Bool shopt_errexit, shopt_errreturn, shopt_pipefail, shopt_unset,
-       shopt_exec, shopt_ignoreeof, shopt_verbose, shopt_xtrace;
+extern _Bool shopt_errexit, shopt_errreturn, shopt_pipefail, shopt_lastpipe,
+       shopt_unset, shopt_exec, shopt_ignoreeof, shopt_verbose, shopt_xtrace;
 extern _Bool shopt_traceall;
 #if YASH_ENABLE_HISTORY
 extern _Bool shopt_histspace;
 #endif
 extern _Bool shopt_glob, shopt_caseglob, shopt_dotglob, shopt_markdirs,
-       shopt_extendedglob, shopt_nullglob;
+       shopt_extendedglob, shopt_nullglob, shopt_forlazyglob,
+       shopt_parallelglob;
 extern _Bool shopt_braceexpand;
 extern _Bool shopt_emptylastfield;
 extern _Bool shopt_clobber;
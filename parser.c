@@ -96,6 +96,7 @@ void comsfree(command_T *c)
 	    case CT_SIMPLE:
 		assignsfree(c->c_assigns);
 		plfree(c->c_words, wordfree_vp);
+		free(c->c_cmdcache);
 		break;
 	    case CT_GROUP:
 	    case CT_SUBSHELL:
@@ -300,7 +301,7 @@ typedef enum tokentype_T {
     /* reserved words */
     TT_IF, TT_THEN, TT_ELSE, TT_ELIF, TT_FI, TT_DO, TT_DONE, TT_CASE, TT_ESAC,
     TT_WHILE, TT_UNTIL, TT_FOR, TT_LBRACE, TT_RBRACE, TT_BANG, TT_IN,
-    TT_FUNCTION,
+    TT_FUNCTION, TT_TIME, TT_COPROC,
 #if YASH_ENABLE_DOUBLE_BRACKET
     TT_DOUBLE_LBRACKET,
 #endif
@@ -392,14 +393,19 @@ bool is_name(const wchar_t *s)
 tokentype_T identify_reserved_word_string(const wchar_t *s)
 {
     /* List of keywords:
-     *    case do done elif else esac fi for function if in then until while
-     *    { } [[ !
+     *    case coproc do done elif else esac fi for function if in then time
+     *    until while { } [[ !
      * The following words are currently not keywords:
-     *    select ]] */
+     *    select ]]
+     * "coproc" and "time" are not keywords in the POSIXly-correct mode so that
+     * utilities of the same names can be invoked. */
     switch (s[0]) {
 	case L'c':
 	    if (s[1] == L'a' && s[2] == L's' && s[3] == L'e' && s[4]== L'\0')
 		return TT_CASE;
+	    if (s[1] == L'o' && s[2] == L'p' && s[3] == L'r' && s[4] == L'o' &&
+		    s[5] == L'c' && s[6] == L'\0' && !posixly_correct)
+		return TT_COPROC;
 	    break;
 	case L'd':
 	    if (s[1] == L'o') {
@@ -438,6 +444,9 @@ tokentype_T identify_reserved_word_string(const wchar_t *s)
 	case L't':
 	    if (s[1] == L'h' && s[2] == L'e' && s[3] == L'n' && s[4]== L'\0')
 		return TT_THEN;
+	    if (s[1] == L'i' && s[2] == L'm' && s[3] == L'e' && s[4]== L'\0' &&
+		    !posixly_correct)
+		return TT_TIME;
 	    break;
 	case L'u':
 	    if (s[1] == L'n' && s[2] == L't' && s[3] == L'i' && s[4] == L'l' &&
@@ -1163,6 +1172,7 @@ wordunit_T *parse_word(parsestate_T *ps, bool testfunc(wchar_t c))
             w->next = NULL;                                              \
             w->wu_type = WT_STRING;                                      \
             w->wu_string = xwcsndup(&ps->src.contents[startindex], len); \
+            w->wu_plain = is_plain_literal(w->wu_string);                \
             *lastp = w;                                                  \
             lastp = &w->next;                                            \
         }                                                                \
@@ -1952,35 +1962,46 @@ next:
     return first;
 }
 
-/* Parses one pipeline.
+/* Parses one pipeline, optionally prefixed by "coproc", "!" and/or "time".
  * If the first word was alias-substituted, the `ps->reparse' flag is set and
  * NULL is returned. */
 pipeline_T *parse_pipeline(parsestate_T *ps)
 {
-    bool neg;
+    bool neg = false, time = false, timep = false, coproc = false;
     command_T *c;
 
-    if (ps->tokentype == TT_BANG) {
-	neg = true;
-	if (posixly_correct && ps->src.contents[ps->next_index] == L'(')
-	    serror(ps, Ngt("ksh-like extended glob pattern `!(...)' "
-			"is not supported"));
-	next_token(ps);
-
-parse_after_bang:
-	c = parse_commands_in_pipeline(ps);
-	if (ps->reparse) {
-	    ps->reparse = false;
-	    assert(c == NULL);
-	    goto parse_after_bang;
+    for (;;) {
+	if (ps->tokentype == TT_COPROC && !coproc && !neg && !time) {
+	    coproc = true;
+	    next_token(ps);
+	    continue;
 	}
-    } else {
-	neg = false;
+	if (ps->tokentype == TT_BANG && !neg) {
+	    neg = true;
+	    if (posixly_correct && ps->src.contents[ps->next_index] == L'(')
+		serror(ps, Ngt("ksh-like extended glob pattern `!(...)' "
+			    "is not supported"));
+	    next_token(ps);
+	    continue;
+	}
+	if (ps->tokentype == TT_TIME && !time) {
+	    time = true;
+	    next_token(ps);
+	    if (is_single_string_word(ps->token) &&
+		    wcscmp(ps->token->wu_string, L"-p") == 0) {
+		timep = true;
+		next_token(ps);
+	    }
+	    continue;
+	}
+
 	c = parse_commands_in_pipeline(ps);
-	if (ps->reparse) {
-	    assert(c == NULL);
+	if (!ps->reparse)
+	    break;
+	assert(c == NULL);
+	if (!neg && !time && !coproc)
 	    return NULL;
-	}
+	ps->reparse = false;
     }
 
     pipeline_T *result = xmalloc(sizeof *result);
@@ -1988,6 +2009,9 @@ parse_after_bang:
     result->pl_commands = c;
     result->pl_neg = neg;
     result->pl_cond = false;
+    result->pl_time = time;
+    result->pl_timep = timep;
+    result->pl_coproc = coproc;
     return result;
 }
 
@@ -2056,6 +2080,7 @@ command_T *parse_command(parsestate_T *ps)
     result->c_type = CT_SIMPLE;
     result->c_assigns = NULL;
     result->c_redirs = NULL;
+    result->c_cmdcache = NULL;
     result->c_words = parse_simple_command_tokens(
 	    ps, &result->c_assigns, &result->c_redirs);
 
@@ -3198,6 +3223,7 @@ void read_heredoc_contents_without_expansion(parsestate_T *ps, redir_T *r)
     wordunit_T *wu = xmalloc(sizeof *wu);
     wu->next = NULL;
     wu->wu_type = WT_STRING;
+    wu->wu_plain = false;
     wu->wu_string = escape(buf.contents, L"\\");
     r->rd_herecontent = wu;
 
@@ -3493,6 +3519,10 @@ void print_pipelines(struct print *restrict pr, const pipeline_T *restrict pl,
 	return;
     for (;;) {
 	print_indent(pr, indent);
+	if (pl->pl_coproc)
+	    wb_cat(&pr->buffer, L"coproc ");
+	if (pl->pl_time)
+	    wb_cat(&pr->buffer, pl->pl_timep ? L"time -p " : L"time ");
 	if (pl->pl_neg)
 	    wb_cat(&pr->buffer, L"! ");
 	print_commands(pr, pl->pl_commands, indent);
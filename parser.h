@@ -46,12 +46,17 @@ typedef struct and_or_T {
 typedef struct pipeline_T {
     struct pipeline_T *next;
     struct command_T  *pl_commands;  /* commands in this pipeline */
-    _Bool              pl_neg, pl_cond;
+    _Bool              pl_neg, pl_cond, pl_time, pl_timep, pl_coproc;
 } pipeline_T;
 /* pl_neg:  indicates this pipeline is prefix by "!", in which case the exit
  *          status of the pipeline is inverted.
  * pl_cond: true if prefixed by "&&", false by "||". Ignored for the first
- *          pipeline in an and/or list. */
+ *          pipeline in an and/or list.
+ * pl_time: indicates this pipeline is prefixed by "time", in which case the
+ *          time taken to execute the pipeline is reported.
+ * pl_timep: true if the "time" is followed by the "-p" option.
+ * pl_coproc: indicates this pipeline is prefixed by "coproc", in which case
+ *          the pipeline is executed asynchronously as a coprocess. */
 
 /* type of command_T */
 typedef enum {
@@ -79,6 +84,7 @@ typedef struct command_T {
 	struct {
 	    struct assign_T *assigns;  /* assignments */
 	    void           **words;    /* command name and arguments */
+	    struct cmdcache_T *cmdcache; /* cache for command search */
 	} simplecommand;
 	struct and_or_T     *subcmds;  /* contents of command group */
 	struct ifcommand_T  *ifcmds;   /* contents of if command */
@@ -105,6 +111,7 @@ typedef struct command_T {
 } command_T;
 #define c_assigns  c_content.simplecommand.assigns
 #define c_words    c_content.simplecommand.words
+#define c_cmdcache c_content.simplecommand.cmdcache
 #define c_subcmds  c_content.subcmds
 #define c_ifcmds   c_content.ifcmds
 #define c_forname  c_content.forloop.forname
@@ -121,7 +128,9 @@ typedef struct command_T {
 /* `c_words' and `c_forwords' are NULL-terminated arrays of pointers to
  * `wordunit_T' that are cast to `void *'.
  * If `c_forwords' is NULL, the for loop doesn't have the "in" clause.
- * If `c_forwords[0]' is NULL, the "in" clause exists and is empty. */
+ * If `c_forwords[0]' is NULL, the "in" clause exists and is empty.
+ * `c_cmdcache' is initially NULL and used in "exec.c" to remember the result
+ * of the last command search. It is a single memory block freed by `free'. */
 
 /* condition and commands of an if command */
 typedef struct ifcommand_T {
@@ -186,6 +195,7 @@ typedef enum {
 typedef struct wordunit_T {
     struct wordunit_T *next;
     wordunittype_T     wu_type;
+    _Bool              wu_plain;  /* see below */
     union {
 	wchar_t           *string;  /* string (including quotes) */
 	struct paramexp_T *param;   /* parameter expansion */
@@ -198,7 +208,11 @@ typedef struct wordunit_T {
 #define wu_cmdsub wu_value.cmdsub
 #define wu_arith  wu_value.arith
 /* In arithmetic expansion, the expression is subject to parameter expansion
- * before it is parsed. So `wu_arith' is of type `wordunit_T *'. */
+ * before it is parsed. So `wu_arith' is of type `wordunit_T *'.
+ * `wu_plain' is meaningful only for WT_STRING. It is true if `wu_string' is
+ * known to be a plain literal (see `is_plain_literal'), which expands to itself
+ * if it is the only word unit in the word. It may be false even if the string
+ * is actually a plain literal. */
 
 /* type of paramexp_T */
 typedef enum {
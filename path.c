@@ -17,6 +17,9 @@
 
 
 #include "common.h"
+#if D_TYPE_NEEDS_DEFAULT_SOURCE
+# define _DEFAULT_SOURCE 1  /* for the DT_* macros on glibc */
+#endif
 #include "path.h"
 #include <assert.h>
 #include <ctype.h>
@@ -31,7 +34,11 @@
 #if HAVE_PATHS_H
 # include <paths.h>
 #endif
+#if HAVE_PTHREAD
+# include <pthread.h>
+#endif
 #include <pwd.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -563,6 +570,8 @@ struct wglob_pattern {
 	} literal;
 	struct {
 	    xfnmatch_T *pattern;
+	    char *prefix, *suffix;
+	    size_t prefixlen, suffixlen;
 	} match;
 	struct {
 	    bool followlink, allowperiod;
@@ -570,6 +579,12 @@ struct wglob_pattern {
     } value;
 };
 
+/* `prefix' and `suffix' of a WGLOB_MATCH component are the literal parts at
+ * the beginning and end of the pattern, which every matching filename must
+ * start and end with. They are used to reject filenames before the pattern
+ * matcher is invoked. They are NULL if not available.
+ * `prefixlen' and `suffixlen' are their lengths in bytes. */
+
 /* Data used in search */
 struct wglob_search {
     plist_T pattern;
@@ -577,6 +592,10 @@ struct wglob_search {
     xstrbuf_T path;
     xwcsbuf_T wpath;
     plist_T *results;
+    wglob_callback_T *callback;
+    void *data;
+    bool stopped;
+    struct wglob_prefetch *prefetch;
 };
 /* `pattern' is an array of pointers to struct wglob_pattern objects. Each
  * wglob_pattern object is called a "component", which corresponds to one
@@ -584,21 +603,102 @@ struct wglob_search {
  * `path' and `wpath' are intermediate pathnames, denoting the currently
  * searched directory. They are the multi-byte and wide string versions of the
  * same pathname. The multi-byte version is mainly used for calling OS APIs and
- * the wide version for producing the final results. */
+ * the wide version for producing the final results.
+ * `prefetch' is non-NULL if directories are read in parallel. */
 
 /* Data used in search for one level of directory */
 struct wglob_stack {
     const struct wglob_stack *prev;
     struct stat st;
+    int fd;
     unsigned char active_components[];
 };
 /* `st' is mainly used to detect recursion into the same directory and prevent
  * infinite search.
+ * `fd' is a file descriptor for the directory while it is being scanned by
+ * `wglob_scandir', or -1 otherwise. Files in the directory are opened and
+ * `stat'ed relative to it so that the whole pathname need not be resolved
+ * each time.
  * The length of `active_components' is the same as that of `pattern' in `struct
  * wglob_search'. When an item of `active_components' is zero, the component is
  * not active. When non-zero, it is active. For a recursive search component,
  * the value is the depth of the current recursion. */
 
+/* Type of a file in a directory, as far as it is known from the directory
+ * entry without calling `stat' */
+enum wglob_filetype_T {
+    WFT_UNKNOWN, WFT_DIRECTORY, WFT_SYMLINK, WFT_OTHER,
+};
+
+/* Contents of a directory read in advance */
+struct wglob_dirlist {
+    enum { WDL_QUEUED, WDL_READING, WDL_DONE, } state;
+    bool opened;
+    xstrbuf_T entries;
+};
+/* `state' is used only in prefetching.
+ * `opened' is false if the directory could not be opened.
+ * `entries' contains the entries of the directory in the order returned by
+ * `readdir'. Each entry consists of a byte of `enum wglob_filetype_T' followed
+ * by the null-terminated name. */
+
+/* An entry of the directory listing cache */
+struct wglob_dircache {
+    char *path;
+    struct stat st;
+    time_t readtime;
+    size_t users;
+    bool evicted;
+    struct wglob_dirlist list;
+};
+/* `path' is the pathname of the directory in the same form as the `path'
+ * member of `struct wglob_search'.
+ * `st' is the result of `stat'ing the directory just before it was read at
+ * `readtime'. The listing is valid while the directory has the same
+ * identity and modification and change times as recorded in `st'.
+ * `users' is the number of `wglob_scandir' calls currently using the listing.
+ * An entry that is evicted from the cache while in use is freed when the last
+ * user releases it. */
+
+#if HAVE_PTHREAD
+
+/* Data shared among the main thread and prefetch threads */
+struct wglob_prefetch {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    hashtable_T dirs;
+    plist_T queue;
+    size_t readahead;
+    bool allowperiod, cancel;
+    size_t threadcount;
+    pthread_t threads[];
+};
+/* Prefetch threads read directories under the root of a recursive search
+ * ahead of the main thread, which performs the actual search using the
+ * contents read by the prefetch threads. As the main thread proceeds in the
+ * same manner as sequential search, the results are the same.
+ * `dirs' is a hashtable mapping the multi-byte pathnames of directories to
+ * `struct wglob_dirlist's. The pathnames are in the same form as the `path'
+ * member of `struct wglob_search'.
+ * `queue' is a list of pathnames of directories that are in the `WDL_QUEUED'
+ * state. The pathnames are owned by `dirs'.
+ * `readahead' is the number of directories in `dirs' that are in the
+ * `WDL_READING' or `WDL_DONE' state, that is, the directories read by the
+ * prefetch threads and not yet taken by the main thread. The prefetch threads
+ * do not start reading another directory while `readahead' is
+ * `WGLOB_PREFETCH_MAX' or more, so that a large tree is not entirely buffered
+ * in memory ahead of the main thread. To avoid waiting for the blocked
+ * threads, the main thread reads a directory itself if it has not been
+ * started reading yet.
+ * If `allowperiod' is true, directories whose names start with a period are
+ * also read.
+ * `mutex' protects all the members but `threadcount' and `threads'. `cond' is
+ * signaled when a directory is queued or read.
+ * Symbolic links are not followed in prefetching because they may lead to
+ * infinite recursion. Such directories are read by the main thread. */
+
+#endif /* HAVE_PTHREAD */
+
 /* The wglob search algorithm used to perform naive search, but it was slow when
  * the pattern contained more than one recursive search component */
 // (e.g. foo/**/bar/**/baz)
@@ -611,6 +711,8 @@ struct wglob_stack {
  * intermediate path and produce a set of active components for the next path.
  */
 
+static void wglob_start(struct wglob_search *s)
+    __attribute__((nonnull));
 static plist_T wglob_parse_pattern(
 	const wchar_t *pattern, enum wglobflags_T flags)
     __attribute__((nonnull,warn_unused_result));
@@ -620,6 +722,16 @@ static struct wglob_pattern *wglob_parse_component(
 static struct wglob_pattern *wglob_create_recsearch_component(
 	bool followlink, bool allowperiod)
     __attribute__((malloc,warn_unused_result));
+static void wglob_extract_literals(const wchar_t *restrict pattern,
+	xfnmflags_T xflags, struct wglob_pattern *restrict c)
+    __attribute__((nonnull));
+static inline bool wglob_literals_match(
+	const struct wglob_pattern *restrict c, const char *restrict name)
+    __attribute__((nonnull,pure));
+static bool wglob_may_match(const char *restrict name,
+	const struct wglob_search *restrict s,
+	const struct wglob_stack *restrict t)
+    __attribute__((nonnull,pure));
 static void wglob_free_pattern(struct wglob_pattern *c);
 static void wglob_free_pattern_vp(void *c);
 
@@ -633,30 +745,86 @@ static void wglob_search_literal_each(
 	struct wglob_search *restrict s, const struct wglob_stack *restrict t)
     __attribute__((nonnull));
 static void wglob_add_result(
-	struct wglob_search *s, bool only_if_existing, bool markdir)
+	struct wglob_search *restrict s, const struct wglob_stack *restrict t,
+	const char *restrict name, enum wglob_filetype_T type,
+	bool only_if_existing, bool markdir)
+    __attribute__((nonnull));
+static void wglob_add_result_value(struct wglob_search *s, wchar_t *result)
     __attribute__((nonnull));
 static void wglob_search_literal_uniq(
 	struct wglob_search *restrict s, struct wglob_stack *restrict t)
     __attribute__((nonnull));
 static bool wglob_scandir(
+	struct wglob_search *restrict s, struct wglob_stack *restrict t)
+    __attribute__((nonnull));
+static DIR *wglob_opendir(
 	struct wglob_search *restrict s, const struct wglob_stack *restrict t)
     __attribute__((nonnull));
+static inline enum wglob_filetype_T wglob_filetype(const struct dirent *de)
+    __attribute__((nonnull,pure));
 static void wglob_scandir_entry(
-	const char *name, struct wglob_search *restrict s,
+	const char *name, enum wglob_filetype_T type,
+	struct wglob_search *restrict s,
 	const struct wglob_stack *restrict t, struct wglob_stack *restrict t2,
 	bool only_if_existing)
     __attribute__((nonnull));
 static bool wglob_should_recurse(
-	const char *restrict name, const char *restrict path,
-	const struct wglob_pattern *restrict c, struct wglob_stack *restrict t,
+	const char *restrict name, enum wglob_filetype_T type,
+	const struct wglob_search *restrict s,
+	const struct wglob_stack *restrict t,
+	const struct wglob_pattern *restrict c, struct wglob_stack *restrict t2,
 	size_t count)
     __attribute__((nonnull));
+static int wglob_stat(
+	const struct wglob_search *restrict s,
+	const struct wglob_stack *restrict t, const char *restrict name,
+	bool followlink, struct stat *restrict st)
+    __attribute__((nonnull));
 static bool wglob_is_reentry(const struct wglob_stack *const t, size_t count)
     __attribute__((nonnull,pure));
 
-static int wglob_sortcmp(const void *v1, const void *v2)
+static const wchar_t *wglob_sortkey(const void *p)
     __attribute__((pure,nonnull));
 
+#if HAVE_PTHREAD
+static struct wglob_prefetch *wglob_prefetch_new(const struct wglob_search *s)
+    __attribute__((nonnull));
+static size_t wglob_thread_count(void);
+static void wglob_prefetch_free(struct wglob_prefetch *p)
+    __attribute__((nonnull));
+static void wglob_dirlist_free(kvpair_T kv);
+static void *wglob_prefetch_main(void *p)
+    __attribute__((nonnull));
+static void wglob_prefetch_enqueue(
+	struct wglob_prefetch *restrict p, plist_T *restrict subdirs)
+    __attribute__((nonnull));
+static void wglob_prefetch_read(
+	const struct wglob_prefetch *restrict p, const char *restrict path,
+	struct wglob_dirlist *restrict d, plist_T *restrict subdirs)
+    __attribute__((nonnull));
+static struct wglob_dirlist *wglob_prefetch_get(
+	struct wglob_prefetch *restrict p, const char *restrict path,
+	bool enqueue)
+    __attribute__((nonnull));
+#endif
+
+static void wglob_read_dirlist(
+	const char *restrict path, struct wglob_dirlist *restrict d)
+    __attribute__((nonnull));
+static bool wglob_scandirlist(struct wglob_search *restrict s,
+	struct wglob_stack *restrict t, const struct wglob_dirlist *restrict d)
+    __attribute__((nonnull));
+static struct wglob_dircache *wglob_dircache_get(const char *path)
+    __attribute__((nonnull));
+static bool wglob_dircache_is_valid(
+	const struct wglob_dircache *restrict c, const struct stat *restrict st,
+	time_t now)
+    __attribute__((nonnull,pure));
+static void wglob_dircache_release(struct wglob_dircache *c)
+    __attribute__((nonnull));
+static void wglob_dircache_free(struct wglob_dircache *c)
+    __attribute__((nonnull));
+
 /* A wide string version of `glob'.
  * Adds all pathnames that matches the specified pattern to the specified list.
  * pattern: the pattern to match
@@ -666,6 +834,7 @@ static int wglob_sortcmp(const void *v1, const void *v2)
  *          WGLB_PERIOD:   L'*' and L'?' match L'.' at the beginning
  *          WGLB_NOSORT:   don't sort resulting items
  *          WGLB_RECDIR:   allow recursive search with L"**"
+ *          WGLB_PARALLEL: read directories in parallel in recursive search
  * list:    a list of pointers to wide strings to which resulting items are
  *          added.
  * Returns true iff successful. However, some result items may be added to the
@@ -687,26 +856,79 @@ bool wglob(const wchar_t *restrict pattern, enum wglobflags_T flags,
     }
 
     s.flags = flags;
-    sb_init(&s.path);
-    wb_init(&s.wpath);
     s.results = list;
+    s.callback = NULL;
+    s.data = NULL;
+#if HAVE_PTHREAD
+    s.prefetch = (flags & WGLB_PARALLEL) ? wglob_prefetch_new(&s) : NULL;
+#else
+    s.prefetch = NULL;
+#endif
+    wglob_start(&s);
 
-    struct wglob_stack *t = wglob_stack_new(&s, NULL);
+    if (!(flags & WGLB_NOSORT)) {
+	size_t count = list->length - listbase;  /* # of resulting items */
+	sort_by_wcscoll(list->contents + listbase, count, sizeof (void *),
+		wglob_sortkey);
+    }
+    return !is_interrupted();
+}
+
+/* Like `wglob', but passes each resulting pathname to `callback' as soon as it
+ * is found instead of adding it to a list. The pathname is a newly malloced
+ * string which the callback is responsible to free. If the callback returns
+ * false, the search is abandoned and this function returns false. `data' is
+ * passed to the callback as is.
+ * The results are never sorted, regardless of WGLB_NOSORT. As the callback is
+ * called during the search, the current working directory must not be changed
+ * in the callback. WGLB_PARALLEL is ignored because the callback may fork the
+ * shell, which must not be done while other threads are running. */
+bool wglob_each(const wchar_t *restrict pattern, enum wglobflags_T flags,
+	wglob_callback_T *callback, void *data)
+{
+    struct wglob_search s;
+
+    s.pattern = wglob_parse_pattern(pattern, flags);
+    if (s.pattern.length == 0) {
+	pl_destroy(&s.pattern);
+	return false;
+    }
+
+    s.flags = flags;
+    s.results = NULL;
+    s.callback = callback;
+    s.data = data;
+    s.prefetch = NULL;
+    wglob_start(&s);
+
+    return !s.stopped && !is_interrupted();
+}
+
+/* Performs the search for `wglob' and `wglob_each'.
+ * `s->pattern', `s->flags', `s->results', `s->callback', `s->data', and
+ * `s->prefetch' must have been initialized. The pattern and the prefetch data
+ * are freed in this function. */
+void wglob_start(struct wglob_search *s)
+{
+    s->stopped = false;
+    sb_init(&s->path);
+    wb_init(&s->wpath);
+
+    struct wglob_stack *t = wglob_stack_new(s, NULL);
     t->active_components[0] = 1;
 
-    wglob_search(&s, t);
+    wglob_search(s, t);
 
     free(t);
 
-    sb_destroy(&s.path);
-    wb_destroy(&s.wpath);
-    plfree(pl_toary(&s.pattern), wglob_free_pattern_vp);
+#if HAVE_PTHREAD
+    if (s->prefetch != NULL)
+	wglob_prefetch_free(s->prefetch);
+#endif
 
-    if (!(flags & WGLB_NOSORT)) {
-	size_t count = list->length - listbase;  /* # of resulting items */
-	qsort(list->contents + listbase, count, sizeof (void *), wglob_sortcmp);
-    }
-    return !is_interrupted();
+    sb_destroy(&s->path);
+    wb_destroy(&s->wpath);
+    plfree(pl_toary(&s->pattern), wglob_free_pattern_vp);
 }
 
 /* Parses the specified pattern.
@@ -768,6 +990,7 @@ struct wglob_pattern *wglob_parse_component(
 	if (!(flags & WGLB_PERIOD))
 	    xflags |= XFNM_PERIOD;
 	result->type = WGLOB_MATCH;
+	wglob_extract_literals(pattern, xflags, result);
 	result->value.match.pattern = xfnm_compile(pattern, xflags);
 	if (result->value.match.pattern == NULL)
 	    goto fail;
@@ -796,6 +1019,91 @@ struct wglob_pattern *wglob_create_recsearch_component(
     return result;
 }
 
+/* Sets the `prefix' and `suffix' of WGLOB_MATCH component `c' to the literal
+ * parts at the beginning and end of `pattern', which is compiled with `xflags'.
+ * When the literal parts cannot be reliably compared byte by byte, i.e., if
+ * the pattern is case-insensitive or the multibyte encoding is
+ * state-dependent, they are left NULL. */
+void wglob_extract_literals(const wchar_t *restrict pattern,
+	xfnmflags_T xflags, struct wglob_pattern *restrict c)
+{
+    c->value.match.prefix = c->value.match.suffix = NULL;
+    c->value.match.prefixlen = c->value.match.suffixlen = 0;
+
+    if ((xflags & XFNM_CASEFOLD) || mblen(NULL, 0) != 0)
+	return;
+
+    xwcsbuf_T prefix, suffix;
+    wb_init(&prefix);
+    wb_init(&suffix);
+
+    /* Characters are appended to `prefix' until the first special character
+     * and to `suffix' after the last one. Brackets are always considered
+     * special, even if escaped, so that the contents of a bracket expression,
+     * which may contain escaped brackets, never end up in the suffix. */
+    bool inprefix = true;
+    for (const wchar_t *p = pattern; *p != L'\0'; p++) {
+	wchar_t c = *p;
+	switch (c) {
+	    case L'\\':
+		if (p[1] != L'\0' && p[1] != L'[' && p[1] != L']') {
+		    c = *++p;
+		    break;
+		}
+		/* falls thru! */
+	    case L'*':  case L'?':  case L'[':  case L']':
+		inprefix = false;
+		wb_clear(&suffix);
+		continue;
+	}
+	if (inprefix)
+	    wb_wccat(&prefix, c);
+	wb_wccat(&suffix, c);
+    }
+    if (inprefix) {
+	/* not a matching pattern actually */
+	wb_clear(&prefix);
+	wb_clear(&suffix);
+    }
+
+    if (prefix.length > 0) {
+	c->value.match.prefix = malloc_wcstombs(prefix.contents);
+	if (c->value.match.prefix != NULL)
+	    c->value.match.prefixlen = strlen(c->value.match.prefix);
+    }
+    if (suffix.length > 0) {
+	c->value.match.suffix = malloc_wcstombs(suffix.contents);
+	if (c->value.match.suffix != NULL)
+	    c->value.match.suffixlen = strlen(c->value.match.suffix);
+    }
+    wb_destroy(&prefix);
+    wb_destroy(&suffix);
+}
+
+/* Checks if filename `name' starts with the prefix and ends with the suffix of
+ * WGLOB_MATCH component `c'. If this function returns false, the filename
+ * never matches the pattern. */
+bool wglob_literals_match(
+	const struct wglob_pattern *restrict c, const char *restrict name)
+{
+    size_t prefixlen = c->value.match.prefixlen;
+    size_t suffixlen = c->value.match.suffixlen;
+
+    if (prefixlen > 0 && strncmp(name, c->value.match.prefix, prefixlen) != 0)
+	return false;
+    if (suffixlen > 0) {
+	/* The prefix and suffix never overlap because the pattern has at least
+	 * one special character between them. */
+	size_t namelen = prefixlen + strlen(&name[prefixlen]);
+	if (namelen < prefixlen + suffixlen)
+	    return false;
+	if (memcmp(&name[namelen - suffixlen], c->value.match.suffix,
+		    suffixlen) != 0)
+	    return false;
+    }
+    return true;
+}
+
 void wglob_free_pattern(struct wglob_pattern *c)
 {
     if (c == NULL)
@@ -808,6 +1116,8 @@ void wglob_free_pattern(struct wglob_pattern *c)
 	    break;
 	case WGLOB_MATCH:
 	    xfnm_free(c->value.match.pattern);
+	    free(c->value.match.prefix);
+	    free(c->value.match.suffix);
 	    break;
 	case WGLOB_RECSEARCH:
 	    break;
@@ -828,6 +1138,7 @@ struct wglob_stack *wglob_stack_new(
     struct wglob_stack *t =
 	xmallocs(sizeof *t, sizeof *t->active_components, s->pattern.length);
     t->prev = prev;
+    t->fd = -1;
     memset(t->active_components, 0, s->pattern.length);
     return t;
 }
@@ -846,7 +1157,7 @@ void wglob_search(
     assert(s->wpath.length == 0 ||
 	    s->wpath.contents[s->wpath.length - 1] == L'/');
 
-    if (is_interrupted())
+    if (s->stopped || is_interrupted())
 	return;
 
     /* find active WGLOB_RECSEARCH components and activate their next component
@@ -896,7 +1207,7 @@ void wglob_search_literal_each(
 {
     size_t savepathlen = s->path.length, savewpathlen = s->wpath.length;
 
-    for (size_t i = 0; i < s->pattern.length; i++) {
+    for (size_t i = 0; i < s->pattern.length && !s->stopped; i++) {
 	if (!t->active_components[i])
 	    continue;
 
@@ -920,7 +1231,8 @@ void wglob_search_literal_each(
 	    free(t2);
 	} else {
 	    /* This is the last component. */
-	    wglob_add_result(s, true, false);
+	    wglob_add_result(s, t, c->value.literal.name, WFT_UNKNOWN,
+		    true, false);
 	}
 
 	sb_truncate(&s->path, savepathlen);
@@ -928,21 +1240,36 @@ void wglob_search_literal_each(
     }
 }
 
-/* Adds `s->path' to `s->results'. */
+/* Adds `s->path' to the results.
+ * `name' is the last component of `s->path', which is a file in the directory
+ * of `t'. `type' is the type of the file if known. */
 void wglob_add_result(
-	struct wglob_search *s, bool only_if_existing, bool markdir)
+	struct wglob_search *restrict s, const struct wglob_stack *restrict t,
+	const char *restrict name, enum wglob_filetype_T type,
+	bool only_if_existing, bool markdir)
 {
+    if (s->stopped)
+	return;
+
     if (!only_if_existing && !markdir) {
-	pl_add(s->results, xwcsdup(s->wpath.contents));
+	wglob_add_result_value(s, xwcsdup(s->wpath.contents));
 	return;
     }
 
-    struct stat st;
-    bool existing = stat(s->path.contents, &st) >= 0;
+    bool existing, isdir;
+    if (!only_if_existing && type == WFT_DIRECTORY) {
+	existing = isdir = true;
+    } else if (!only_if_existing && type == WFT_OTHER) {
+	existing = true, isdir = false;
+    } else {
+	struct stat st;
+	existing = wglob_stat(s, t, name, true, &st) >= 0;
+	isdir = existing && S_ISDIR(st.st_mode);
+    }
     if (only_if_existing && !existing)
 	return;
-    if (!markdir || !existing || !S_ISDIR(st.st_mode)) {
-	pl_add(s->results, xwcsdup(s->wpath.contents));
+    if (!markdir || !isdir) {
+	wglob_add_result_value(s, xwcsdup(s->wpath.contents));
 	return;
     }
 
@@ -951,7 +1278,17 @@ void wglob_add_result(
     wb_initwithmax(&result, length);
     wb_cat(&result, s->wpath.contents);
     wb_wccat(&result, L'/');
-    pl_add(s->results, wb_towcs(&result));
+    wglob_add_result_value(s, wb_towcs(&result));
+}
+
+/* Adds the newly malloced string `result' to `s->results' or passes it to
+ * `s->callback'. */
+void wglob_add_result_value(struct wglob_search *s, wchar_t *result)
+{
+    if (s->callback == NULL)
+	pl_add(s->results, result);
+    else if (!s->callback(result, s->data))
+	s->stopped = true;
 }
 
 /* Applies active components to the current directory path and continues
@@ -979,10 +1316,10 @@ void wglob_search_literal_uniq(
 
     /* descend down for each name */
     struct wglob_stack *t2 = wglob_stack_new(s, t);
-    for (const kvpair_T *n = names; n->key != NULL; n++) {
+    for (const kvpair_T *n = names; n->key != NULL && !s->stopped; n++) {
 	const struct wglob_pattern *c = n->value;
 	memset(t2->active_components, 0, s->pattern.length);
-	wglob_scandir_entry(c->value.literal.name, s, t, t2, true);
+	wglob_scandir_entry(c->value.literal.name, WFT_UNKNOWN, s, t, t2, true);
     }
 
     free(t2);
@@ -993,42 +1330,145 @@ void wglob_search_literal_uniq(
  * searching subdirectories.
  * Returns true if the directory could be searched. */
 bool wglob_scandir(
-	struct wglob_search *restrict s, const struct wglob_stack *restrict t)
+	struct wglob_search *restrict s, struct wglob_stack *restrict t)
 {
-    DIR* dir = opendir((s->path.length == 0) ? "." : s->path.contents);
+#if HAVE_PTHREAD
+    if (s->prefetch != NULL) {
+	/* Prefetching is started at the root of recursive search. */
+	bool recursive = false;
+	for (size_t i = 0; i < s->pattern.length; i++) {
+	    const struct wglob_pattern *c = s->pattern.contents[i];
+	    if (t->active_components[i] && c->type == WGLOB_RECSEARCH)
+		recursive = true;
+	}
+
+	struct wglob_dirlist *d =
+	    wglob_prefetch_get(s->prefetch, s->path.contents, recursive);
+	if (d != NULL) {
+	    bool result = wglob_scandirlist(s, t, d);
+	    sb_destroy(&d->entries);
+	    free(d);
+	    return result;
+	}
+    }
+#endif
+
+    if (is_interactive_now) {
+	struct wglob_dircache *c = wglob_dircache_get(s->path.contents);
+	if (c != NULL) {
+	    bool result = wglob_scandirlist(s, t, &c->list);
+	    wglob_dircache_release(c);
+	    return result;
+	}
+    }
+
+    if (s->callback != NULL) {
+	/* The callback may run arbitrary commands, which could close or
+	 * redirect the file descriptor of an open directory, so the whole
+	 * directory is read before any result is passed to the callback. */
+	struct wglob_dirlist d = { .opened = false, };
+	sb_init(&d.entries);
+	wglob_read_dirlist(s->path.contents, &d);
+	bool result = wglob_scandirlist(s, t, &d);
+	sb_destroy(&d.entries);
+	return result;
+    }
+
+    DIR *dir = wglob_opendir(s, t);
     if (dir == NULL)
 	return false;
 
+#if HAVE_OPENAT
+    t->fd = dirfd(dir);
+#endif
+
     struct wglob_stack *t2 = wglob_stack_new(s, t);
 
     /* An empty name, which is needed for empty literal components, must be
      * explicitly produced as it would never be returned from readdir. */
-    wglob_scandir_entry("", s, t, t2, true);
+    wglob_scandir_entry("", WFT_UNKNOWN, s, t, t2, true);
 
     /* now try each directory entry */
     struct dirent *de;
-    while ((de = readdir(dir)) != NULL) {
+    while (!s->stopped && (de = readdir(dir)) != NULL) {
 	memset(t2->active_components, 0, s->pattern.length);
-	wglob_scandir_entry(de->d_name, s, t, t2, false);
+	wglob_scandir_entry(de->d_name, wglob_filetype(de), s, t, t2, false);
     }
+    t->fd = -1;
     closedir(dir);
 
     free(t2);
     return true;
 }
 
+/* Opens the directory `s->path' for `wglob_scandir'.
+ * If the parent directory is being scanned, the directory is opened relative
+ * to it. */
+DIR *wglob_opendir(struct wglob_search *restrict s,
+	const struct wglob_stack *restrict t __attribute__((unused)))
+{
+#if HAVE_OPENAT
+    if (t->prev != NULL && t->prev->fd >= 0) {
+	/* find the last component of the path, which ends with a slash */
+	size_t end = s->path.length - 1, start = end;
+	assert(s->path.contents[end] == '/');
+	while (start > 0 && s->path.contents[start - 1] != '/')
+	    start--;
+
+	if (start < end) {
+	    s->path.contents[end] = '\0';
+	    int fd = openat(t->prev->fd, &s->path.contents[start],
+		    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	    s->path.contents[end] = '/';
+	    if (fd < 0)
+		return NULL;
+
+	    DIR *dir = fdopendir(fd);
+	    if (dir == NULL)
+		xclose(fd);
+	    return dir;
+	}
+    }
+#endif
+
+    return opendir((s->path.length == 0) ? "." : s->path.contents);
+}
+
+/* Returns the type of the file of the specified directory entry. */
+enum wglob_filetype_T wglob_filetype(const struct dirent *de)
+{
+#if HAVE_DIRENT_D_TYPE
+    switch (de->d_type) {
+	case DT_UNKNOWN:  return WFT_UNKNOWN;
+	case DT_DIR:      return WFT_DIRECTORY;
+	case DT_LNK:      return WFT_SYMLINK;
+	default:          return WFT_OTHER;
+    }
+#else
+    (void) de;
+    return WFT_UNKNOWN;
+#endif
+}
+
 /* Checks if each active component matches the given `name' in the current
  * directory path and continues searching subdirectories.
  * `t' is the stack frame for the current directory path and `t2' for the next
  * frame. `t2->prev' must be `t' and `t2->active_components' must have been
  * zeroed.
+ * `type' is the type of the file if known.
  * `only_if_existing' is passed to `wglob_add_result' and should be false iff
  * the `name' is known to be an existing file. */
 void wglob_scandir_entry(
-	const char *name, struct wglob_search *restrict s,
+	const char *name, enum wglob_filetype_T type,
+	struct wglob_search *restrict s,
 	const struct wglob_stack *restrict t, struct wglob_stack *restrict t2,
 	bool only_if_existing)
 {
+    /* Most entries in a large directory are rejected here, before the
+     * pathname is converted to a wide string. */
+    if (!wglob_may_match(name, s, t))
+	return;
+
     size_t savepathlen = s->path.length, savewpathlen = s->wpath.length;
 
     sb_cat(&s->path, name);
@@ -1048,7 +1488,7 @@ void wglob_scandir_entry(
 		if (i + 1 < s->pattern.length) // has a next component?
 		    t2->active_components[i + 1] = 1;
 		else
-		    wglob_add_result(s, only_if_existing, false);
+		    wglob_add_result(s, t, name, type, only_if_existing, false);
 		break;
 	    case WGLOB_MATCH:
 		if (name[0] == '\0')
@@ -1058,16 +1498,16 @@ void wglob_scandir_entry(
 		if (i + 1 < s->pattern.length) // has a next component?
 		    t2->active_components[i + 1] = 1;
 		else
-		    wglob_add_result(s, only_if_existing, s->flags & WGLB_MARK);
+		    wglob_add_result(s, t, name, type, only_if_existing,
+			    s->flags & WGLB_MARK);
 		break;
 	    case WGLOB_RECSEARCH:
 		assert(i + 1 < s->pattern.length);
 		if (name[0] == '\0')
 		    continue;
 		if (t2->active_components[i] == 0) {
-		    const char *path = s->path.contents;
 		    size_t count = t->active_components[i] - 1;
-		    if (wglob_should_recurse(name, path, c, t2, count))
+		    if (wglob_should_recurse(name, type, s, t, c, t2, count))
 			t2->active_components[i] = t->active_components[i] + 1;
 		}
 		break;
@@ -1085,12 +1525,44 @@ done:
     wb_truncate(&s->wpath, savewpathlen);
 }
 
-/* Decides if we should continue recursion on this component.
- * In this function, `t->st' is updated to the result of `stat'ing the `path'.
- */
+/* Returns false if `name' surely matches none of the active components of `t'.
+ * Only inexpensive tests are done in this function, so it may return true
+ * even if `name' does not match any component. */
+bool wglob_may_match(const char *restrict name,
+	const struct wglob_search *restrict s,
+	const struct wglob_stack *restrict t)
+{
+    for (size_t i = 0; i < s->pattern.length; i++) {
+	if (!t->active_components[i])
+	    continue;
+
+	const struct wglob_pattern *c = s->pattern.contents[i];
+	switch (c->type) {
+	    case WGLOB_LITERAL:
+		if (strcmp(c->value.literal.name, name) == 0)
+		    return true;
+		break;
+	    case WGLOB_MATCH:
+		if (name[0] != '\0' && wglob_literals_match(c, name))
+		    return true;
+		break;
+	    case WGLOB_RECSEARCH:
+		return true;
+	}
+    }
+    return false;
+}
+
+/* Decides if we should continue recursion on this component into the file
+ * `name' in the directory of `t'. `s->path' must be the pathname of the file.
+ * `type' is the type of the file if known.
+ * In this function, `t2->st' may be updated to the result of `stat'ing the
+ * file. */
 bool wglob_should_recurse(
-	const char *restrict name, const char *restrict path,
-	const struct wglob_pattern *restrict c, struct wglob_stack *restrict t,
+	const char *restrict name, enum wglob_filetype_T type,
+	const struct wglob_search *restrict s,
+	const struct wglob_stack *restrict t,
+	const struct wglob_pattern *restrict c, struct wglob_stack *restrict t2,
 	size_t count)
 {
     if (c->value.recsearch.allowperiod) {
@@ -1101,17 +1573,50 @@ bool wglob_should_recurse(
 	    return false;
     }
 
-    int (*statfunc)(const char *path, struct stat *st) =
-	c->value.recsearch.followlink ? stat : lstat;
-    if (statfunc(path, &t->st) < 0)
+    bool followlink = c->value.recsearch.followlink;
+    switch (type) {
+	case WFT_UNKNOWN:
+	    break;
+	case WFT_DIRECTORY:
+	    /* Without following symbolic links, we never enter the same
+	     * directory again, so we don't need `stat' for the check. */
+	    if (!followlink)
+		return true;
+	    break;
+	case WFT_SYMLINK:
+	    if (!followlink)
+		return false;
+	    break;
+	case WFT_OTHER:
+	    return false;
+    }
+
+    if (wglob_stat(s, t, name, followlink, &t2->st) < 0)
 	return false;
-    if (!S_ISDIR(t->st.st_mode))
+    if (!S_ISDIR(t2->st.st_mode))
 	return false;
-    if (wglob_is_reentry(t, count))
+    if (wglob_is_reentry(t2, count))
 	return false;
     return true;
 }
 
+/* `stat's the file `name' in the directory of `t'. `s->path' must be the
+ * pathname of the file. Symbolic links are followed iff `followlink' is true.
+ * The return value is that of `stat'. */
+int wglob_stat(
+	const struct wglob_search *restrict s,
+	const struct wglob_stack *restrict t, const char *restrict name,
+	bool followlink, struct stat *restrict st)
+{
+#if HAVE_OPENAT
+    if (t->fd >= 0 && name[0] != '\0')
+	return fstatat(t->fd, name, st, followlink ? 0 : AT_SYMLINK_NOFOLLOW);
+#else
+    (void) t, (void) name;
+#endif
+    return followlink ? stat(s->path.contents, st) : lstat(s->path.contents, st);
+}
+
 /* Returns true iff a file that is the same as `t->st' appears in `count'
  * ancestors of `t'. */
 bool wglob_is_reentry(const struct wglob_stack *const t, size_t count)
@@ -1124,11 +1629,459 @@ bool wglob_is_reentry(const struct wglob_stack *const t, size_t count)
     return false;
 }
 
-int wglob_sortcmp(const void *v1, const void *v2)
+/* Returns the pathname pointed to by `p', which is a (const wchar_t *const *).
+ * Used as the `getkey' function to `sort_by_wcscoll'. */
+const wchar_t *wglob_sortkey(const void *p)
+{
+    return *(const wchar_t *const *) p;
+}
+
+#if HAVE_PTHREAD
+
+/* Starts prefetch threads for the search.
+ * Returns NULL if the pattern contains no recursive search component or no
+ * thread can be started. */
+struct wglob_prefetch *wglob_prefetch_new(const struct wglob_search *s)
+{
+    bool recursive = false, allowperiod = false;
+    for (size_t i = 0; i < s->pattern.length; i++) {
+	const struct wglob_pattern *c = s->pattern.contents[i];
+	if (c->type == WGLOB_RECSEARCH) {
+	    recursive = true;
+	    if (c->value.recsearch.allowperiod)
+		allowperiod = true;
+	}
+    }
+    if (!recursive)
+	return NULL;
+
+    size_t threadcount = wglob_thread_count();
+    if (threadcount == 0)
+	return NULL;
+
+    struct wglob_prefetch *p =
+	xmallocs(sizeof *p, threadcount, sizeof *p->threads);
+    if (pthread_mutex_init(&p->mutex, NULL) != 0) {
+	free(p);
+	return NULL;
+    }
+    if (pthread_cond_init(&p->cond, NULL) != 0) {
+	pthread_mutex_destroy(&p->mutex);
+	free(p);
+	return NULL;
+    }
+    ht_init(&p->dirs, hashstr, htstrcmp);
+    pl_init(&p->queue);
+    p->readahead = 0;
+    p->allowperiod = allowperiod;
+    p->cancel = false;
+
+    /* Signals must be handled by the main thread only. */
+    sigset_t all, saved;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+    for (p->threadcount = 0; p->threadcount < threadcount; p->threadcount++)
+	if (pthread_create(&p->threads[p->threadcount], NULL,
+		    wglob_prefetch_main, p) != 0)
+	    break;
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+
+    if (p->threadcount == 0) {
+	wglob_prefetch_free(p);
+	return NULL;
+    }
+    return p;
+}
+
+/* Returns the number of prefetch threads to use, which is taken from the
+ * $YASH_GLOB_THREADS variable. */
+size_t wglob_thread_count(void)
+{
+#ifndef GLOB_THREADS_DEFAULT
+#define GLOB_THREADS_DEFAULT 4
+#endif
+#ifndef GLOB_THREADS_MAX
+#define GLOB_THREADS_MAX 64
+#endif
+
+    const wchar_t *v = getvar(L VAR_YASH_GLOB_THREADS);
+    if (v != NULL) {
+	int i;
+	if (xwcstoi(v, 10, &i) && i >= 0)
+	    return (i <= GLOB_THREADS_MAX) ? (size_t) i : GLOB_THREADS_MAX;
+    }
+    return GLOB_THREADS_DEFAULT;
+}
+
+/* Stops the prefetch threads and frees the prefetch data. */
+void wglob_prefetch_free(struct wglob_prefetch *p)
+{
+    pthread_mutex_lock(&p->mutex);
+    p->cancel = true;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+
+    for (size_t i = 0; i < p->threadcount; i++)
+	pthread_join(p->threads[i], NULL);
+
+    pl_destroy(&p->queue);
+    ht_clear(&p->dirs, wglob_dirlist_free);
+    ht_destroy(&p->dirs);
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->mutex);
+    free(p);
+}
+
+/* Frees the pathname and the `struct wglob_dirlist' in the specified pair. */
+void wglob_dirlist_free(kvpair_T kv)
 {
-    return wcscoll(*(const wchar_t *const *) v1, *(const wchar_t *const *) v2);
+    struct wglob_dirlist *d = kv.value;
+    free(kv.key);
+    sb_destroy(&d->entries);
+    free(d);
 }
 
+/* The maximum number of directories read ahead of the main thread */
+#ifndef WGLOB_PREFETCH_MAX
+#define WGLOB_PREFETCH_MAX 64
+#endif
+
+/* The main function of prefetch threads.
+ * Each thread reads queued directories and queues their subdirectories until
+ * cancelled. */
+void *wglob_prefetch_main(void *pp)
+{
+    struct wglob_prefetch *p = pp;
+    plist_T subdirs;
+    pl_init(&subdirs);
+
+    pthread_mutex_lock(&p->mutex);
+    for (;;) {
+	while (!p->cancel && (p->queue.length == 0 ||
+		    p->readahead >= WGLOB_PREFETCH_MAX))
+	    pthread_cond_wait(&p->cond, &p->mutex);
+	if (p->cancel)
+	    break;
+
+	/* The queue is used as a stack so that the directories are read in
+	 * the same depth-first order as the main thread searches them. */
+	const char *path = p->queue.contents[p->queue.length - 1];
+	pl_truncate(&p->queue, p->queue.length - 1);
+	struct wglob_dirlist *d = ht_get(&p->dirs, path).value;
+	assert(d != NULL && d->state == WDL_QUEUED);
+	d->state = WDL_READING;
+	p->readahead++;
+	pthread_mutex_unlock(&p->mutex);
+
+	wglob_prefetch_read(p, path, d, &subdirs);
+
+	pthread_mutex_lock(&p->mutex);
+	d->state = WDL_DONE;
+	wglob_prefetch_enqueue(p, &subdirs);
+	pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->mutex);
+
+    pl_destroy(&subdirs);
+    return NULL;
+}
+
+/* Queues the subdirectories returned from `wglob_prefetch_read' for
+ * prefetching unless already queued, and clears `subdirs'.
+ * The caller must hold `p->mutex'. */
+void wglob_prefetch_enqueue(
+	struct wglob_prefetch *restrict p, plist_T *restrict subdirs)
+{
+    for (size_t i = subdirs->length; i-- > 0; ) {
+	char *subdir = subdirs->contents[i];
+	if (ht_get(&p->dirs, subdir).key != NULL) {
+	    free(subdir);
+	    continue;
+	}
+
+	struct wglob_dirlist *d = xmalloc(sizeof *d);
+	d->state = WDL_QUEUED;
+	d->opened = false;
+	sb_init(&d->entries);
+	ht_set(&p->dirs, subdir, d);
+	pl_add(&p->queue, subdir);
+    }
+    pl_truncate(subdirs, 0);
+}
+
+/* Reads the directory `path' into `d' without locking.
+ * Newly malloced pathnames of subdirectories that should be read next are
+ * added to `subdirs'. */
+void wglob_prefetch_read(
+	const struct wglob_prefetch *restrict p, const char *restrict path,
+	struct wglob_dirlist *restrict d, plist_T *restrict subdirs)
+{
+    wglob_read_dirlist(path, d);
+
+    const char *entry = d->entries.contents;
+    const char *end = &d->entries.contents[d->entries.length];
+    for (; entry < end; entry = &entry[strlen(entry) + 1]) {
+	enum wglob_filetype_T type = (enum wglob_filetype_T) *entry++;
+	const char *name = entry;
+	if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0 ||
+		(!p->allowperiod && name[0] == '.'))
+	    continue;
+	if (type != WFT_UNKNOWN && type != WFT_DIRECTORY)
+	    continue;
+
+	xstrbuf_T subdir;
+	sb_init(&subdir);
+	sb_cat(&subdir, path);
+	sb_cat(&subdir, name);
+
+	struct stat st;
+	if (type == WFT_DIRECTORY ||
+		(lstat(subdir.contents, &st) == 0 && S_ISDIR(st.st_mode))) {
+	    sb_ccat(&subdir, '/');
+	    pl_add(subdirs, sb_tostr(&subdir));
+	} else {
+	    sb_destroy(&subdir);
+	}
+    }
+}
+
+/* Returns the contents of the directory `path' read by a prefetch thread,
+ * waiting for the thread to finish reading if necessary.
+ * If no prefetch thread has started reading the directory, it is read in the
+ * calling thread if it has been queued for prefetching or `enqueue' is true;
+ * otherwise, NULL is returned. The subdirectories of a directory read in the
+ * calling thread are queued for prefetching.
+ * The result is removed from `p->dirs' and must be freed by the caller. */
+struct wglob_dirlist *wglob_prefetch_get(
+	struct wglob_prefetch *restrict p, const char *restrict path,
+	bool enqueue)
+{
+    pthread_mutex_lock(&p->mutex);
+
+    kvpair_T kv = ht_get(&p->dirs, path);
+    struct wglob_dirlist *d = kv.value;
+    if (d == NULL || d->state == WDL_QUEUED) {
+	if (d != NULL) {
+	    /* The key is shared with the queue, so remove it from both. */
+	    for (size_t i = p->queue.length; i-- > 0; ) {
+		if (p->queue.contents[i] == kv.key) {
+		    pl_remove(&p->queue, i, 1);
+		    break;
+		}
+	    }
+	    ht_remove(&p->dirs, path);
+	    free(kv.key);
+	} else if (enqueue) {
+	    d = xmalloc(sizeof *d);
+	    d->opened = false;
+	    sb_init(&d->entries);
+	} else {
+	    pthread_mutex_unlock(&p->mutex);
+	    return NULL;
+	}
+	d->state = WDL_READING;
+	pthread_mutex_unlock(&p->mutex);
+
+	plist_T subdirs;
+	pl_init(&subdirs);
+	wglob_prefetch_read(p, path, d, &subdirs);
+	d->state = WDL_DONE;
+
+	pthread_mutex_lock(&p->mutex);
+	wglob_prefetch_enqueue(p, &subdirs);
+	pthread_cond_broadcast(&p->cond);
+	pthread_mutex_unlock(&p->mutex);
+
+	pl_destroy(&subdirs);
+	return d;
+    }
+
+    while (d->state != WDL_DONE)
+	pthread_cond_wait(&p->cond, &p->mutex);
+
+    kv = ht_remove(&p->dirs, path);
+    assert(kv.value == d);
+    assert(p->readahead > 0);
+    p->readahead--;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+
+    free(kv.key);
+    return d;
+}
+
+#endif /* HAVE_PTHREAD */
+
+/* Reads all the entries of the directory `path' into `d', which must have
+ * been initialized with `d->opened' false and `d->entries' empty. */
+void wglob_read_dirlist(
+	const char *restrict path, struct wglob_dirlist *restrict d)
+{
+    DIR *dir = opendir((path[0] == '\0') ? "." : path);
+    if (dir == NULL)
+	return;
+    d->opened = true;
+
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+	sb_ccat(&d->entries, (char) wglob_filetype(de));
+	sb_ncat_force(&d->entries, de->d_name, strlen(de->d_name) + 1);
+    }
+    closedir(dir);
+}
+
+/* Like `wglob_scandir', but uses the directory contents read in advance. */
+bool wglob_scandirlist(struct wglob_search *restrict s,
+	struct wglob_stack *restrict t, const struct wglob_dirlist *restrict d)
+{
+    if (!d->opened)
+	return false;
+
+    struct wglob_stack *t2 = wglob_stack_new(s, t);
+
+    wglob_scandir_entry("", WFT_UNKNOWN, s, t, t2, true);
+
+    const char *entry = d->entries.contents;
+    const char *end = &d->entries.contents[d->entries.length];
+    while (!s->stopped && entry < end) {
+	const char *name = &entry[1];
+	memset(t2->active_components, 0, s->pattern.length);
+	wglob_scandir_entry(name, (enum wglob_filetype_T) entry[0],
+		s, t, t2, false);
+	entry = &name[strlen(name) + 1];
+    }
+
+    free(t2);
+    return true;
+}
+
+/* The directory listing cache.
+ * Interactive shells keep the listings of recently scanned directories so that
+ * repeated pathname expansion and filename completion in the same directory do
+ * not have to read it again. The array is ordered from the most recently used
+ * entry. */
+#ifndef WGLOB_DIRCACHE_SIZE
+#define WGLOB_DIRCACHE_SIZE 8
+#endif
+/* Cached listings older than this number of seconds are discarded even if the
+ * directory seems unchanged, in case the file system does not update the
+ * modification time reliably. */
+#ifndef WGLOB_DIRCACHE_TTL
+#define WGLOB_DIRCACHE_TTL 5
+#endif
+static struct wglob_dircache *dircache[WGLOB_DIRCACHE_SIZE];
+
+/* Returns the listing of the directory `path', which is taken from the cache
+ * if valid or otherwise read and added to the cache.
+ * Returns NULL if the directory cannot be `stat'ed.
+ * The result must be released by `wglob_dircache_release' after use. */
+struct wglob_dircache *wglob_dircache_get(const char *path)
+{
+    struct stat st;
+    if (stat((path[0] == '\0') ? "." : path, &st) < 0 || !S_ISDIR(st.st_mode))
+	return NULL;
+
+    time_t now = time(NULL);
+    size_t i;
+    for (i = 0; i < WGLOB_DIRCACHE_SIZE && dircache[i] != NULL; i++)
+	if (strcmp(dircache[i]->path, path) == 0)
+	    break;
+
+    struct wglob_dircache *c;
+    if (i < WGLOB_DIRCACHE_SIZE && dircache[i] != NULL) {
+	c = dircache[i];
+	if (!wglob_dircache_is_valid(c, &st, now)) {
+	    /* remove the stale entry */
+	    memmove(&dircache[i], &dircache[i + 1],
+		    (WGLOB_DIRCACHE_SIZE - i - 1) * sizeof *dircache);
+	    dircache[WGLOB_DIRCACHE_SIZE - 1] = NULL;
+	    c->evicted = true;
+	    if (c->users == 0)
+		wglob_dircache_free(c);
+	    c = NULL;
+	    i = WGLOB_DIRCACHE_SIZE;
+	}
+    } else {
+	c = NULL;
+    }
+
+    if (c == NULL) {
+	c = xmalloc(sizeof *c);
+	c->path = xstrdup(path);
+	c->st = st;
+	c->readtime = now;
+	c->users = 0;
+	c->evicted = false;
+	c->list.opened = false;
+	sb_init(&c->list.entries);
+	wglob_read_dirlist(path, &c->list);
+
+	/* If the directory was modified in the same second as it was read, a
+	 * later modification may not change the modification time, so the
+	 * listing is not cached. */
+	if (st.st_mtime >= now) {
+	    c->evicted = true;
+	    c->users++;
+	    return c;
+	}
+
+	i = WGLOB_DIRCACHE_SIZE - 1;
+	struct wglob_dircache *old = dircache[i];
+	if (old != NULL) {
+	    old->evicted = true;
+	    if (old->users == 0)
+		wglob_dircache_free(old);
+	}
+    }
+
+    /* move the entry to the front */
+    memmove(&dircache[1], &dircache[0], i * sizeof *dircache);
+    dircache[0] = c;
+    c->users++;
+    return c;
+}
+
+/* Checks if cached listing `c' is still valid for the directory whose current
+ * `stat' result is `st'. */
+bool wglob_dircache_is_valid(
+	const struct wglob_dircache *restrict c, const struct stat *restrict st,
+	time_t now)
+{
+    if (!stat_result_same_file(&c->st, st))
+	return false;
+    if (now < c->readtime || now - c->readtime > WGLOB_DIRCACHE_TTL)
+	return false;
+    if (c->st.st_mtime != st->st_mtime || c->st.st_ctime != st->st_ctime)
+	return false;
+#if HAVE_ST_MTIM
+    if (c->st.st_mtim.tv_nsec != st->st_mtim.tv_nsec ||
+	    c->st.st_ctim.tv_nsec != st->st_ctim.tv_nsec)
+	return false;
+#elif HAVE_ST_MTIMESPEC
+    if (c->st.st_mtimespec.tv_nsec != st->st_mtimespec.tv_nsec ||
+	    c->st.st_ctimespec.tv_nsec != st->st_ctimespec.tv_nsec)
+	return false;
+#endif
+    return true;
+}
+
+/* Releases the cached listing returned from `wglob_dircache_get'. */
+void wglob_dircache_release(struct wglob_dircache *c)
+{
+    assert(c->users > 0);
+    c->users--;
+    if (c->users == 0 && c->evicted)
+	wglob_dircache_free(c);
+}
+
+void wglob_dircache_free(struct wglob_dircache *c)
+{
+    free(c->path);
+    sb_destroy(&c->list.entries);
+    free(c);
+}
+
+
 
 /********** Built-ins **********/
 
@@ -95,6 +95,7 @@ enum wglobflags_T {
     WGLB_PERIOD   = 1 << 2,
     WGLB_NOSORT   = 1 << 3,
     WGLB_RECDIR   = 1 << 4,
+    WGLB_PARALLEL = 1 << 5,
 };
 
 struct plist_T;
@@ -103,6 +104,11 @@ extern _Bool wglob(const wchar_t *restrict pattern, enum wglobflags_T flags,
 	struct plist_T *restrict list)
     __attribute__((nonnull));
 
+typedef _Bool wglob_callback_T(wchar_t *path, void *data);
+extern _Bool wglob_each(const wchar_t *restrict pattern,
+	enum wglobflags_T flags, wglob_callback_T *callback, void *data)
+    __attribute__((nonnull(1,3)));
+
 
 /********** Built-ins **********/
 
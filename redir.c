@@ -292,8 +292,6 @@ struct savefd_T {
 
 static char *expand_redir_filename(const struct wordunit_T *filename)
     __attribute__((malloc,warn_unused_result));
-static void save_fd(int oldfd, savefd_T **save)
-    __attribute__((nonnull));
 static int open_file(const char *path, int oflag)
     __attribute__((nonnull));
 #if YASH_ENABLE_SOCKET
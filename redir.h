@@ -45,6 +45,8 @@ struct redir_T;
 
 extern _Bool open_redirections(const struct redir_T *r, savefd_T **save)
     __attribute__((nonnull(2)));
+extern void save_fd(int oldfd, savefd_T **save)
+    __attribute__((nonnull));
 extern void undo_redirections(savefd_T *save);
 extern void clear_savefd(savefd_T *save);
 extern void maybe_redirect_stdin_to_devnull(void);
@@ -22,25 +22,34 @@
 #include <ctype.h>
 #include <errno.h>
 #include <limits.h>
+#if HAVE_PPOLL
+# include <poll.h>
+#endif
 #include <signal.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/select.h>
+#if !HAVE_PPOLL
+# include <sys/select.h>
+#endif
+#include <time.h>
 #include <wchar.h>
 #include <wctype.h>
 #if HAVE_GETTEXT
 # include <libintl.h>
 #endif
+#include "alias.h"
 #include "builtin.h"
 #include "exec.h"
 #include "expand.h"
+#include "input.h"
 #include "job.h"
 #include "option.h"
 #include "parser.h"
 #include "redir.h"
+#include "refcount.h"
 #include "siglist.h"
 #include "signum.h"
 #include "strbuf.h"
@@ -52,6 +61,11 @@
 # include "lineedit/lineedit.h"
 #endif
 
+#if HAVE_PPOLL && !defined(ppoll)
+extern int ppoll(struct pollfd *fds, nfds_t nfds,
+	const struct timespec *timeout, const sigset_t *sigmask);
+#endif
+
 
 /* About the shell's signal handling:
  *
@@ -92,6 +106,12 @@ static void handle_sigchld(void);
 static void set_trap(int signum, const wchar_t *command);
 static bool is_originally_ignored(int signum);
 static void banish_phantoms(void);
+static struct parsedtrap_T *parse_trap_command(const wchar_t *command)
+    __attribute__((nonnull,malloc,warn_unused_result));
+static void free_parsedtrap(struct parsedtrap_T *pt);
+static void exec_trap_command(const wchar_t *command,
+	struct parsedtrap_T **parsedp, const char *codename)
+    __attribute__((nonnull));
 #if YASH_ENABLE_LINEEDIT
 # ifdef SIGWINCH
 static inline void handle_sigwinch(void);
@@ -242,19 +262,36 @@ static volatile sig_atomic_t any_signal_received = false;
 /* the signal for which trap is currently executed */
 static int handled_signal = -1;
 
+/* trap command parsed in advance */
+typedef struct parsedtrap_T {
+    refcount_T refcount;
+    bool preparsed;          /* false if `commands' cannot be used */
+    and_or_T *commands;      /* parse result, which may be null if empty */
+    unsigned long aliasgen;  /* value of `alias_generation' when parsed */
+    bool posix;              /* value of `posixly_correct' when parsed */
+} parsedtrap_T;
+/* A trap command is parsed when the trap is set so that the command need not
+ * be parsed every time the signal is caught. The parse result is invalidated
+ * when the trap is reset or when aliases or the POSIXly-correct mode, which
+ * affect the result of parsing, are changed. The reference count prevents the
+ * result from being freed while it is being executed. */
+
 /* flags to indicate a signal is caught. */
 static volatile sig_atomic_t signal_received[MAXSIGIDX];
 /* commands to be executed when a signal is trapped (caught). */
 static wchar_t *trap_command[MAXSIGIDX];
+/* parsed forms of `trap_command', which may be null */
+static parsedtrap_T *trap_parsed[MAXSIGIDX];
 /* These arrays are indexed by `sigindex'. The index 0 is for the EXIT trap. */
 
-/* `signal_received' and `trap_command' for real-time signals. */
+/* `signal_received', `trap_command' and `trap_parsed' for real-time signals. */
 #if defined SIGRTMIN && defined SIGRTMAX
 # if RTSIZE == 0
 #  error "RTSIZE == 0"
 # endif
 static volatile sig_atomic_t rtsignal_received[RTSIZE];
 static wchar_t *rttrap_command[RTSIZE];
+static parsedtrap_T *rttrap_parsed[RTSIZE];
 #endif
 
 /* If true, the contents of `trap_command` and `rttrap_command` are all
@@ -382,6 +419,27 @@ void restore_signals(bool leave)
     }
 }
 
+#if HAVE_POSIX_SPAWN
+
+/* Checks if the signal settings that `restore_signals(true)' would apply can be
+ * achieved by exec alone, that is, without changing any signal handler in the
+ * child process. If so, stores the signal mask for the child in `*mask' and
+ * returns true. Exec resets caught signals to "default" and leaves ignored
+ * signals ignored, so this is the case unless the job-control or interactive
+ * handlers are set or SIGCHLD, which the shell catches, was ignored on entry to
+ * the shell and must be ignored again in the child. */
+bool get_sigmask_for_spawn(sigset_t *mask)
+{
+    if (job_handlers_set || interactive_handlers_set)
+	return false;
+    if (main_handler_set && sigismember(&officially_ignored_signals, SIGCHLD))
+	return false;
+    *mask = official_sigmask;
+    return true;
+}
+
+#endif /* HAVE_POSIX_SPAWN */
+
 /* Re-sets the signal handler for SIGTTIN, SIGTTOU, and SIGTSTP according to the
  * current `doing_job_control_now' and `job_handlers_set'. */
 void reset_job_signals(void)
@@ -563,16 +621,22 @@ void sig_handler(int signum)
 }
 
 /* Accepts currently pending signals and calls `handle_sigchld' and
- * `handle_traps'. */
+ * `handle_traps'.
+ * This function is called after every command, so pending signals are
+ * accepted only if any of them may affect the shell: when no traps are set,
+ * the shell is not interactive, and there are no jobs, the signals can be left
+ * pending until they are accepted at another time. */
 void handle_signals(void)
 {
-    sigset_t ss = accept_sigmask, savess;
-    sigdelset(&ss, SIGCHLD);
-    if (interactive_handlers_set)
-	sigdelset(&ss, SIGINT);
-    sigemptyset(&savess);
-    sigprocmask(SIG_SETMASK, &ss, &savess);
-    sigprocmask(SIG_SETMASK, &savess, NULL);
+    if (any_trap_set || interactive_handlers_set || any_job_exists()) {
+	sigset_t ss = accept_sigmask, savess;
+	sigdelset(&ss, SIGCHLD);
+	if (interactive_handlers_set)
+	    sigdelset(&ss, SIGINT);
+	sigemptyset(&savess);
+	sigprocmask(SIG_SETMASK, &ss, &savess);
+	sigprocmask(SIG_SETMASK, &savess, NULL);
+    }
 
     handle_sigchld();
     handle_traps();
@@ -633,10 +697,12 @@ enum wait_for_input_T wait_for_input(int fd, bool trap, int timeout)
     struct timespec *top;
 
     assert(fd >= 0);
+#if !HAVE_PPOLL
     if (fd >= FD_SETSIZE) {
 	xerror(0, Ngt("too many files are opened for yash to handle"));
 	return W_ERROR;
     }
+#endif
 
     if (trap)
 	sigint_received = false;
@@ -670,17 +736,33 @@ enum wait_for_input_T wait_for_input(int fd, bool trap, int timeout)
 	    return W_INTERRUPTED;
 	}
 
+#if HAVE_PPOLL
+	/* Unlike `pselect', `ppoll' is not limited by FD_SETSIZE. */
+	struct pollfd pfd = { .fd = fd, .events = POLLIN, };
+
+	int count = ppoll(&pfd, 1, top, &ss);
+#else
 	fd_set fdset;
 	FD_ZERO(&fdset);
 	FD_SET(fd, &fdset);
 
 	int count = pselect(fd + 1, &fdset, NULL, NULL, top, &ss);
+#endif
 
 	if (trap && sigint_received) {
 	    sigint_received = false;
 	    return W_INTERRUPTED;
 	}
 
+#if HAVE_PPOLL
+	if (count >= 0)
+	    return (count > 0) ? W_READY : W_TIMED_OUT;
+
+	if (errno != EINTR) {
+	    xerror(errno, "ppoll");
+	    return W_ERROR;
+	}
+#else
 	if (count >= 0)
 	    return FD_ISSET(fd, &fdset) ? W_READY : W_TIMED_OUT;
 
@@ -688,6 +770,7 @@ enum wait_for_input_T wait_for_input(int fd, bool trap, int timeout)
 	    xerror(errno, "pselect");
 	    return W_ERROR;
 	}
+#endif
     }
 }
 
@@ -699,28 +782,29 @@ void handle_sigchld(void)
         do_wait();
     }
 
-    if (any_job_status_has_changed()) {
-	/* print job status if the notify option is set */
+    /* print job status if the notify option is set */
+    /* The options are tested first because `any_job_status_has_changed' scans
+     * the whole job list, and this function is called on every wake-up. */
 #if YASH_ENABLE_LINEEDIT
-	if (le_state & LE_STATE_ACTIVE) {
-	    if (!(le_state & LE_STATE_COMPLETING)) {
-		if (shopt_notify || shopt_notifyle) {
-		    le_suspend_readline();
-		    print_job_status_all();
-		    le_resume_readline();
-		}
+    if (le_state & LE_STATE_ACTIVE) {
+	if (!(le_state & LE_STATE_COMPLETING)) {
+	    if ((shopt_notify || shopt_notifyle)
+		    && any_job_status_has_changed()) {
+		le_suspend_readline();
+		print_job_status_all();
+		le_resume_readline();
 	    }
-	} else
-#endif
-	if (shopt_notify) {
-	    sigset_t ss, savess;
-	    sigemptyset(&ss);
-	    sigaddset(&ss, SIGTTOU);
-	    sigemptyset(&savess);
-	    sigprocmask(SIG_BLOCK, &ss, &savess);
-	    print_job_status_all();
-	    sigprocmask(SIG_SETMASK, &savess, NULL);
 	}
+    } else
+#endif
+    if (shopt_notify && any_job_status_has_changed()) {
+	sigset_t ss, savess;
+	sigemptyset(&ss);
+	sigaddset(&ss, SIGTTOU);
+	sigemptyset(&savess);
+	sigprocmask(SIG_BLOCK, &ss, &savess);
+	print_job_status_all();
+	sigprocmask(SIG_SETMASK, &savess, NULL);
     }
 }
 
@@ -765,9 +849,7 @@ int handle_traps(void)
 		    struct execstate_T *execstate = save_execstate();
 		    reset_execstate(true);
 		    signum = handled_signal = s->no;
-		    command = xwcsdup(command);
-		    exec_wcs(command, "trap", false);
-		    free(command);
+		    exec_trap_command(command, &trap_parsed[i], "trap");
 		    cancel_return();
 		    restore_execstate(execstate);
 		    laststatus = savelaststatus;
@@ -789,9 +871,7 @@ int handle_traps(void)
 		    struct execstate_T *execstate = save_execstate();
 		    reset_execstate(true);
 		    signum = handled_signal = sigrtmin + i;
-		    command = xwcsdup(command);
-		    exec_wcs(command, "trap", false);
-		    free(command);
+		    exec_trap_command(command, &rttrap_parsed[i], "trap");
 		    cancel_return();
 		    restore_execstate(execstate);
 		    laststatus = savelaststatus;
@@ -820,17 +900,118 @@ void execute_exit_trap(void)
     if (is_phantom)
 	return;
 
-    wchar_t *command = trap_command[sigindex(0)];
+    size_t index = sigindex(0);
+    wchar_t *command = trap_command[index];
     if (command != NULL) {
 	savelaststatus = laststatus;
-	command = xwcsdup(command);
 	reset_execstate(true);
-	exec_wcs(command, "EXIT trap", false);
-	free(command);
+	exec_trap_command(command, &trap_parsed[index], "EXIT trap");
 	savelaststatus = -1;
     }
 }
 
+/* Parses the specified trap command in advance.
+ * A command consisting of more than one line cannot be parsed in advance
+ * because aliases defined in a line affect parsing of the following lines.
+ * A command that contains a syntax error is not parsed in advance either so
+ * that the error is reported when the command is executed. For such commands,
+ * the `preparsed' flag of the returned object is false. */
+parsedtrap_T *parse_trap_command(const wchar_t *command)
+{
+    parsedtrap_T *pt = xmalloc(sizeof *pt);
+    pt->refcount = 1;
+    pt->preparsed = false;
+    pt->commands = NULL;
+    pt->aliasgen = alias_generation;
+    pt->posix = posixly_correct;
+
+    struct input_wcs_info_T iinfo = {
+	.src = command,
+    };
+    struct parseparam_T pinfo = {
+	.print_errmsg = false,
+	.enable_verbose = false,
+	.enable_alias = true,
+	.filename = NULL,
+	.lineno = 1,
+	.input = input_wcs,
+	.inputinfo = &iinfo,
+	.interactive = false,
+    };
+
+    for (;;) {
+	and_or_T *commands;
+	switch (read_and_parse(&pinfo, &commands)) {
+	    case PR_OK:
+		if (commands == NULL)
+		    break;
+		if (pt->commands != NULL) {
+		    andorsfree(commands);
+		    goto fail;
+		}
+		pt->commands = commands;
+		break;
+	    case PR_EOF:
+		pt->preparsed = true;
+		return pt;
+	    case PR_SYNTAX_ERROR:
+	    case PR_INPUT_ERROR:
+		goto fail;
+	}
+    }
+
+fail:
+    andorsfree(pt->commands);
+    pt->commands = NULL;
+    return pt;
+}
+
+/* Decreases the reference count of the parsed trap command and, if the count
+ * becomes zero, frees it. This function does nothing if `pt' is a null
+ * pointer. */
+void free_parsedtrap(parsedtrap_T *pt)
+{
+    if (pt != NULL) {
+	if (refcount_decrement(&pt->refcount)) {
+	    andorsfree(pt->commands);
+	    free(pt);
+	}
+    }
+}
+
+/* Executes the specified trap command.
+ * `*parsedp' is the parsed form of the command, which is updated if it has not
+ * yet been parsed or the previous parse result is no longer valid.
+ * `codename' is passed to `exec_wcs' if the command cannot be executed in the
+ * parsed form. */
+void exec_trap_command(
+	const wchar_t *command, parsedtrap_T **parsedp, const char *codename)
+{
+    parsedtrap_T *pt = *parsedp;
+    if (pt == NULL
+	    || pt->aliasgen != alias_generation
+	    || pt->posix != posixly_correct) {
+	free_parsedtrap(pt);
+	*parsedp = pt = parse_trap_command(command);
+    }
+
+    if (!pt->preparsed || !(shopt_exec || is_interactive)) {
+	wchar_t *copy = xwcsdup(command);
+	exec_wcs(copy, codename, false);
+	free(copy);
+	return;
+    }
+
+    /* The trap may be reset during the execution, so we keep our own
+     * reference to the parse result. */
+    refcount_increment(&pt->refcount);
+    if (pt->commands != NULL)
+	exec_and_or_lists(pt->commands, false);
+    else
+	laststatus = Exit_SUCCESS;
+    free_parsedtrap(pt);
+}
+
 /* Sets trap for the signal `signum' to `command'.
  * If `command' is NULL, the trap is reset to the default.
  * If `command' is an empty string, the trap is set to SIG_IGN.
@@ -846,6 +1027,7 @@ void set_trap(int signum, const wchar_t *command)
     }
 
     wchar_t **commandp;
+    parsedtrap_T **parsedp;
     volatile sig_atomic_t *receivedp;
 #if defined SIGRTMIN && defined SIGRTMAX
     int sigrtmin = SIGRTMIN;
@@ -853,6 +1035,7 @@ void set_trap(int signum, const wchar_t *command)
 	size_t index = signum - sigrtmin;
 	if (index < RTSIZE) {
 	    commandp = &rttrap_command[index];
+	    parsedp = &rttrap_parsed[index];
 	    receivedp = &rtsignal_received[index];
 	} else {
 	    xerror(0, Ngt("real-time signal SIG%ls is not supported"),
@@ -864,6 +1047,7 @@ void set_trap(int signum, const wchar_t *command)
     {
 	size_t index = sigindex(signum);
 	commandp = &trap_command[index];
+	parsedp = &trap_parsed[index];
 	receivedp = &signal_received[index];
     }
 
@@ -878,9 +1062,13 @@ void set_trap(int signum, const wchar_t *command)
 
     if (!is_phantom) {
 	free(*commandp);
+	free_parsedtrap(*parsedp);
+	*parsedp = NULL;
 	if (command != NULL) {
-	    if (command[0] != L'\0')
+	    if (command[0] != L'\0') {
 		any_trap_set = true;
+		*parsedp = parse_trap_command(command);
+	    }
 	    *commandp = xwcsdup(command);
 	} else {
 	    *commandp = NULL;
@@ -1022,6 +1210,8 @@ void banish_phantoms(void)
 	if (command != NULL && command[0] != L'\0') {
 	    free(command);
 	    trap_command[index] = NULL;
+	    free_parsedtrap(trap_parsed[index]);
+	    trap_parsed[index] = NULL;
 	}
     }
     for (const signal_T *s = signals; s->no != 0; s++) {
@@ -1030,6 +1220,8 @@ void banish_phantoms(void)
 	if (command != NULL && command[0] != L'\0') {
 	    free(command);
 	    trap_command[index] = NULL;
+	    free_parsedtrap(trap_parsed[index]);
+	    trap_parsed[index] = NULL;
 	}
     }
 #if defined SIGRTMIN && defined SIGRTMAX
@@ -1038,6 +1230,8 @@ void banish_phantoms(void)
 	if (command != NULL && command[0] != L'\0') {
 	    free(command);
 	    rttrap_command[i] = NULL;
+	    free_parsedtrap(rttrap_parsed[i]);
+	    rttrap_parsed[i] = NULL;
 	}
     }
 #endif
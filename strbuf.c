@@ -410,6 +410,31 @@ xwcsbuf_T *wb_wccat(xwcsbuf_T *buf, wchar_t c)
     return buf;
 }
 
+/* Appends the collation key of wide string `s' to buffer `buf'.
+ * Comparing two keys with `wcscmp' gives the same result as comparing the
+ * original strings with `wcscoll'. If the key cannot be computed, `s' itself
+ * is appended. */
+xwcsbuf_T *wb_wcsxfrmcat(xwcsbuf_T *restrict buf, const wchar_t *restrict s)
+{
+    for (;;) {
+	size_t avail = buf->maxlength - buf->length;
+	int saveerrno = errno;
+	errno = 0;
+	size_t n = wcsxfrm(&buf->contents[buf->length], s, avail + 1);
+	bool error = (errno != 0);
+	errno = saveerrno;
+	if (error) {
+	    buf->contents[buf->length] = L'\0';
+	    return wb_cat(buf, s);
+	}
+	if (n <= avail) {
+	    buf->length += n;
+	    return buf;
+	}
+	wb_ensuremax(buf, add(buf->length, n));
+    }
+}
+
 /* Converts multibyte string `s' into a wide string and appends it to buffer
  * `buf'. The multibyte string is assumed to start in the initial shift state.
  * Returns NULL if the whole string is converted and appended successfully,
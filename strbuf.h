@@ -167,6 +167,9 @@ static inline xwcsbuf_T *wb_remove(xwcsbuf_T *buf, size_t i, size_t n)
     __attribute__((nonnull));
 extern xwcsbuf_T *wb_wccat(xwcsbuf_T *buf, wchar_t c)
     __attribute__((nonnull));
+extern xwcsbuf_T *wb_wcsxfrmcat(
+	xwcsbuf_T *restrict buf, const wchar_t *restrict s)
+    __attribute__((nonnull));
 extern char *wb_mbscat(xwcsbuf_T *restrict buf, const char *restrict s)
     __attribute__((nonnull));
 extern int wb_vwprintf(
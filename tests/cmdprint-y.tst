@@ -123,6 +123,26 @@ __IN__
 }
 __OUT__
 
+test_single 'timed pipeline, single line'
+time -p ! cat fifo | cat - | cat
+__IN__
+time -p ! cat fifo | cat - | cat
+__OUT__
+
+test_multi 'timed pipeline, multi-line'
+{ time echo | cat - | cat; }
+__IN__
+{
+   time echo | cat - | cat
+}
+__OUT__
+
+test_single 'coprocess, single line'
+coproc ! cat fifo | cat - | cat
+__IN__
+coproc ! cat fifo | cat - | cat
+__OUT__
+
 # Non-empty grouping is tested in other tests above.
 
 test_single 'grouping, w/o commands, single line'
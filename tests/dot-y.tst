@@ -188,4 +188,28 @@ __ERR__
 #'
 #`
 
+(
+n="$(ulimit -n 2>/dev/null)"
+if [ "$n" != unlimited ] && [ "${n:-0}" -lt 1200 ]; then
+    skip="true"
+fi
+
+test_oE 'file is read from file descriptor above FD_SETSIZE'
+# All lower file descriptors are occupied so that the shell has to use a file
+# descriptor that is too large for select to read the sourced file.
+i=3
+while [ "$i" -lt 1100 ]; do
+    command eval "exec $i</dev/null" 2>/dev/null
+    i=$((i+1))
+done
+echo 'echo sourced' >file
+. ./file
+echo $?
+__IN__
+sourced
+0
+__OUT__
+
+)
+
 # vim: set ft=sh ts=8 sts=4 sw=4 noet:
@@ -71,6 +71,110 @@ B
 X
 __OUT__
 
+test_oE 'words are expanded before loop starts'
+set -o braceexpand
+v='a b'
+for i in "$v" $v{1,2}; do
+    IFS= v=X
+    echo "$i"
+done
+__IN__
+a b
+a
+b1
+a
+b2
+__OUT__
+
+test_oE 'files created in loop are not globbed'
+mkdir glob
+>glob/a
+for f in glob/*; do
+    echo $f
+    >glob/b
+done
+__IN__
+glob/a
+__OUT__
+
+test_oE 'breaking loop over long brace sequence'
+set -o braceexpand
+for i in x{1..1000000000}; do
+    echo $i
+    if [ $i = x3 ]; then break; fi
+done
+__IN__
+x1
+x2
+x3
+__OUT__
+
+test_oE 'numeric brace sequences as whole words'
+set -o braceexpand
+for i in {-3..3..2}; do printf '[%s]' $i; done; echo
+for i in {08..11}; do printf '[%s]' $i; done; echo
+for i in {+1..-1}; do printf '[%s]' $i; done; echo
+for i in {-05..5..5}; do printf '[%s]' $i; done; echo
+for i in {1..1000000000}; do
+    if [ $i -ge 3 ]; then break; fi
+    printf '[%s]' $i
+done; echo
+__IN__
+[-3][-1][1][3]
+[08][09][10][11]
+[+1][+0][-1]
+[-05][000][005]
+[1][2]
+__OUT__
+
+test_oE 'pathname expansion in loop (-o forlazyglob)'
+set -o forlazyglob
+mkdir lazy lazy/a lazy/b
+>lazy/a/x >lazy/b/y >lazy/b/z
+for d in lazy/*; do
+    for f in $d/*; do
+	echo $f
+    done
+done | sort
+for f in lazy/*/no_such_file lazy/*/[yz]; do
+    echo $f
+    break
+done
+__IN__
+lazy/a/x
+lazy/b/y
+lazy/b/z
+lazy/*/no_such_file
+__OUT__
+
+test_oE 'redirection in loop body (-o forlazyglob)'
+set -o forlazyglob
+mkdir lazyfd
+i=0
+while [ $i -lt 3000 ]; do
+    >lazyfd/file_with_a_fairly_long_name_$i
+    i=$((i+1))
+done
+n=0
+for f in lazyfd/*; do
+    exec 3</dev/null 4</dev/null 5</dev/null 6</dev/null 7</dev/null
+    n=$((n+1))
+done
+echo $n
+__IN__
+3000
+__OUT__
+
+test_oE 'pathname expansion with nullglob (-o forlazyglob)'
+set -o forlazyglob -o nullglob
+for f in no_such_file*; do
+    echo not reached $f
+done
+echo done
+__IN__
+done
+__OUT__
+
 test_oE 'effect of empty for loop (-o POSIX)'
 echo 1
 for i in i
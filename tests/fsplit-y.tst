@@ -80,4 +80,146 @@ __IN__
 [1][][][][]
 __OUT__
 
+test_oE 'IFS changed between expansions is applied to each'
+a='1 2:3'
+for IFS in ' ' : ' :' ' ' ''; do
+    bracket $a
+done
+__IN__
+[1][2:3]
+[1 2][3]
+[1][2][3]
+[1][2:3]
+[1 2:3]
+__OUT__
+
+test_oE 'empty IFS performs no field splitting'
+IFS=
+a='1  2:3' b=' x y '
+bracket $a $b "$a"$b
+__IN__
+[1  2:3][ x y ][1  2:3 x y ]
+__OUT__
+
+test_oE 'unset IFS splits at default separators'
+unset IFS
+a='1  2:3' b=' x y '
+bracket $a $b x$b"y"
+__IN__
+[1][2:3][x][y][x][x][y][y]
+__OUT__
+
+test_oE '"$@" adjacent to unquoted text'
+b=' x y '
+set -- '1 2' '' 3
+bracket x"$@"y
+bracket $b"$@"$b
+bracket "$@"$b
+set --
+bracket x"$@"y
+bracket "$@"$b
+__IN__
+[x1 2][][3y]
+[x][y][1 2][][3][x][y]
+[1 2][][3][x][y]
+[xy]
+[x][y]
+__OUT__
+
+test_oE 'pathname expansion of split fields'
+>a1 >a2 >b1
+p='a* c* b?'
+bracket $p
+__IN__
+[a1][a2][c*][b1]
+__OUT__
+
+test_oE 'pathname expansion of split fields with noglob' -f
+>a1 >a2 >b1
+p='a* c* b?'
+bracket $p
+__IN__
+[a*][c*][b?]
+__OUT__
+
+test_oE 'pathname expansion of split fields with nullglob' --nullglob
+>a1 >a2 >b1
+p='a* c* b?'
+bracket $p
+__IN__
+[a1][a2][b1]
+__OUT__
+
+test_oE 'IFS mixing whitespace and non-whitespace'
+IFS=' :'
+a='  1 : 2::3 :  : 4  '; bracket $a
+a=':'; bracket $a
+a='::'; bracket $a
+a=' : : '; bracket $a
+IFS='	x:'
+a='	1x	x2:	3	'; bracket $a
+__IN__
+[1][2][][3][][4]
+[]
+[][]
+[][]
+[1][][2][3]
+__OUT__
+
+test_oE 'adjacent empty fields'
+IFS=:
+a='::1:::2::'
+bracket $a
+bracket x$a"y"
+bracket $a$a
+for f in $a; do printf '[%s]' "$f"; done; echo
+__IN__
+[][][1][][][2][]
+[x][][1][][][2][][y]
+[][][1][][][2][][][][1][][][2][]
+[][][1][][][2][]
+__OUT__
+
+(
+if ! testee -c 'a=$(printf "\303\251"); [ "${#a}" -eq 1 ]'; then
+    skip="true"
+fi
+
+test_oE 'non-ASCII IFS characters'
+e=$(printf '\303\251') # e with acute accent
+s=$(printf '\343\200\200') # ideographic space
+IFS="$e"
+a="${e}1${e}${e}2"; bracket $a
+IFS="x${e}:"
+a="1x2${e}3:4"; bracket $a
+IFS="$s"
+a="${s}${s}1${s}${s}2${s}"; bracket $a
+IFS=" $e"
+a=" 1 $e 2${e}${e} 3 "; bracket $a
+__IN__
+[][1][][2]
+[1][2][3][4]
+[1][2]
+[1][2][][3]
+__OUT__
+
+test_oE 'non-ASCII field contents'
+e=$(printf '\303\251') # e with acute accent
+show() { for f do printf '[%s:%d]' "${f//$e/E}" "${#f}"; done; echo; }
+a="$e$e $e${e}x$e  $e"
+show $a
+for f in $a; do show "$f"; done
+IFS=:
+a="$e::$e$e:"
+show $a x$a"$e"
+__IN__
+[EE:2][EExE:4][E:1]
+[EE:2]
+[EExE:4]
+[E:1]
+[E:1][:0][EE:2][xE:2][:0][EE:2][E:1]
+__OUT__
+
+)
+
 # vim: set ft=sh ts=8 sts=4 sw=4 noet:
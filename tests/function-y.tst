@@ -126,6 +126,35 @@ initial
 redefined
 __OUT__
 
+test_oE 'redefining and unsetting function while running same command'
+for i in 1 2 3 4; do
+    echo $i
+    case $i in
+	(1) echo() { command echo function "$@"; } ;;
+	(2) echo() { command echo redefined "$@"; } ;;
+	(3) unset -f echo ;;
+    esac
+done
+__IN__
+1
+function 2
+redefined 3
+4
+__OUT__
+
+test_oE 'same command switching between built-in and function'
+func() { printf 'func %s\n' "$@"; }
+for cmd in func printf func; do
+    $cmd '%s\n' x
+done
+__IN__
+func %s\n
+func x
+x
+func %s\n
+func x
+__OUT__
+
 test_o 'effect of redefining read-only function'
 func() { echo foo; }
 readonly -f func
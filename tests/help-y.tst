@@ -551,7 +551,7 @@ __IN__
 jobs: print info about jobs
 
 Syntax:
-	jobs [-lnprs] [job...]
+	jobs [-lnprsu] [job...]
 
 Options:
 	-l       --verbose
@@ -559,6 +559,7 @@ Options:
 	-p       --pgid-only
 	-r       --running-only
 	-s       --stopped-only
+	-u       --usage
 	         --help
 
 Try `man yash' for details.
@@ -597,6 +598,25 @@ Try `man yash' for details.
 __OUT__
 #`
 
+test_oE -e 0 'help of parmap'
+help parmap
+__IN__
+parmap: run a command for each argument in parallel
+
+Syntax:
+	parmap [-gk] [-a array] [-j count] command [argument...]
+
+Options:
+	-a ...   --status-array=...
+	-g       --group
+	-j ...   --jobs=...
+	-k       --keep-order
+	         --help
+
+Try `man yash' for details.
+__OUT__
+#`
+
 (
 if ! testee -c 'command -bv popd' >/dev/null; then
     skip="true"
@@ -771,12 +791,14 @@ Options:
 	         -o errreturn
 	+n       -o exec
 	         -o extendedglob
+	         -o forlazyglob
 	         -o forlocal
 	+f       -o glob
 	-h       -o hashondef
 	         -o histspace
 	         -o ignoreeof
 	-i       -o interactive
+	         -o lastpipe
 	         -o lealwaysrp
 	         -o lecompdebug
 	         -o leconvmeta
@@ -792,6 +814,7 @@ Options:
 	-b       -o notify
 	         -o notifyle
 	         -o nullglob
+	         -o parallelglob
 	         -o pipefail
 	         -o posixlycorrect
 	-s       -o stdin
@@ -1055,9 +1078,12 @@ wait: wait for jobs to terminate
 
 Syntax:
 	wait [job or process_id...]
+	wait -n [-p variable] [job or process_id...]
 
 Options:
-	--help
+	-n       --next
+	-p ...   --pid-variable=...
+	         --help
 
 Try `man yash' for details.
 __OUT__
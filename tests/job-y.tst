@@ -15,4 +15,20 @@ cat sync
 wait $pid
 __IN__
 
+test_oE 'job numbers are reused from lowest after jobs finish out of order'
+sleep 10 & p1=$!
+sleep 11 & p2=$!
+sleep 12 & p3=$!
+kill $p3 $p1
+wait $p3 $p1
+sleep 13 & q1=$!
+sleep 14 & q2=$!
+jobs
+kill $p2 $q1 $q2
+__IN__
+[1] - Running              sleep 13
+[2]   Running              sleep 11
+[3] + Running              sleep 14
+__OUT__
+
 # vim: set ft=sh ts=8 sts=4 sw=4 noet:
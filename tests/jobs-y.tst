@@ -92,6 +92,41 @@ exec 3>>|4
 jobs >&-
 __IN__
 
+test_oE 'jobs: printing resource usage'
+true &
+while kill -0 $! 2>/dev/null; do :; done
+jobs -u >jobs_usage
+sed 's/[0-9][0-9]*/N/g' jobs_usage
+jobs
+echo \$?=$?
+__IN__
+[N] + Done                 true
+      user N.Ns  system N.Ns  max RSS N  blocks in N  blocks out N
+$?=0
+__OUT__
+
+test_oE 'resource usage of foreground job in YASH_RUSAGE'
+sh -c 'exit 3' | cat
+set -- "$YASH_RUSAGE"
+echo $#
+for value do
+    case $value in
+	(*[!.0-9]*) echo "invalid value: $value" ;;
+    esac
+done
+__IN__
+5
+__OUT__
+
+test_oE 'read-only YASH_RUSAGE is silently left unchanged'
+YASH_RUSAGE=(a b)
+readonly YASH_RUSAGE
+sh -c 'exit 3' | cat
+echo "$YASH_RUSAGE"
+__IN__
+a b
+__OUT__
+
 (
 posix=true
 
@@ -105,4 +140,16 @@ __ERR__
 
 )
 
+test_oE 'jobs in subshell are forgotten by wait'
+sleep 10 & p1=$!
+sleep 11 & p2=$!
+(jobs; wait; echo $?; jobs; sleep 12 & p3=$!; jobs; kill $p3)
+kill $p1 $p2
+__IN__
+[1] - Running              sleep 10
+[2] + Running              sleep 11
+0
+[1] + Running              sleep 12
+__OUT__
+
 # vim: set ft=sh ts=8 sts=4 sw=4 noet:
@@ -845,6 +845,38 @@ __IN__
 [1::  ::3]
 __OUT__
 
+test_oE 'plain expansion of set variable with nounset' -u
+v='1 2'
+bracket ${v} $v "${v}"
+__IN__
+[1][2][1][2][1 2]
+__OUT__
+
+test_O -d -e 2 'plain expansion of unset variable with nounset' -u
+unset v
+bracket ${v}
+__IN__
+
+test_oE 'plain expansion of array'
+a=(1 '2 3' 4)
+bracket $a
+bracket "$a"
+bracket ${a}
+bracket x${a}y
+__IN__
+[1][2][3][4]
+[1][2 3][4]
+[1][2][3][4]
+[x1][2][3][4y]
+__OUT__
+
+test_oE 'indexed expansion of array'
+a=(1 '2 3' 4)
+bracket ${a[2]} "${a[2]}" ${a[-1]} ${a[2,3]}
+__IN__
+[2][3][2 3][4][2][3][4]
+__OUT__
+
 (
 posix="true"
 
@@ -0,0 +1,107 @@
+# parmap-y.tst: yash-specific test of the parmap built-in
+
+mkfifo sync
+
+setup - <<\__END__
+f() { echo "$1"; return "$1"; }
+__END__
+
+test_oE 'external command is run for each argument'
+parmap -j 1 basename /a/1 /b/2
+__IN__
+1
+2
+__OUT__
+
+test_oE 'built-in is run for each argument'
+parmap -j 1 echo a b c
+__IN__
+a
+b
+c
+__OUT__
+
+test_oE 'function is run for each argument'
+parmap -j 1 f 1 2 3
+__IN__
+1
+2
+3
+__OUT__
+
+test_oE 'commands are run in subshells'
+g() { x=$1; }
+x=0
+parmap g 1 2
+echo $x
+__IN__
+0
+__OUT__
+
+test_oE 'exit statuses are assigned to array'
+parmap -j 2 -a st f 0 3 0 5 >/dev/null
+echo $? "${st[*]}"
+__IN__
+3 0 3 0 5
+__OUT__
+
+test_oE 'commands run concurrently'
+g() { if [ "$1" = 1 ]; then cat sync; echo 1; else echo 2; >sync; fi; }
+parmap -j 2 g 1 2
+__IN__
+2
+1
+__OUT__
+
+test_oE 'output is printed in order of arguments (-k)'
+g() { if [ "$1" = 1 ]; then cat sync; echo 1; else echo 2; >sync; fi; }
+parmap -j 2 -k g 1 2
+__IN__
+1
+2
+__OUT__
+
+test_oE 'output of each command is printed at once (-g)'
+g() { if [ "$1" = 1 ]; then echo 1a; cat sync; echo 1b; else echo 2; >sync; fi; }
+out="$(parmap -j 2 -g g 1 2)"
+case $out in
+    (2?1a?1b|1a?1b?2) echo ok;;
+    (*) printf '%s\n' "$out";;
+esac
+__IN__
+ok
+__OUT__
+
+test_x -e 0 'no arguments'
+parmap true
+__IN__
+
+test_Oe -e 127 'command not found'
+parmap _no_such_command_ a
+__IN__
+parmap: no such command `_no_such_command_'
+__ERR__
+#'
+#`
+
+test_Oe -e 2 'missing command operand'
+parmap
+__IN__
+parmap: this command requires an operand
+__ERR__
+
+test_Oe -e 2 'non-positive job count'
+parmap -j 0 true a
+__IN__
+parmap: 0 is not a positive integer
+__ERR__
+
+test_Oe -e 2 'invalid option'
+parmap --no-such-option
+__IN__
+parmap: `--no-such-option' is not a valid option
+__ERR__
+#'
+#`
+
+# vim: set ft=sh ts=8 sts=4 sw=4 noet:
@@ -11,6 +11,9 @@ mkdir -p "bar/a[b/c]d"
 
 mkdir -p baz/.dir/.file
 
+mkdir qux
+>qux/a]c >qux/ab]c >qux/x.o >qux/xy.o >qux/y.o >qux/xy
+
 test_oE 'expansion with read-and-searchable directory'
 echo foo/*dir
 echo foo/d*r/f*e
@@ -39,6 +42,22 @@ foo[/]dir[/]file
 bar/a[b/c]d
 __OUT__
 
+test_oE 'literal characters around pattern'
+echo qux/x*.o
+echo qux/x?.o
+echo qux/\x*\o
+echo qux/*[]]c
+echo qux/a[]b]*c
+echo qux/xy*
+__IN__
+qux/x.o qux/xy.o
+qux/xy.o
+qux/x.o qux/xy.o
+qux/a]c qux/ab]c
+qux/a]c qux/ab]c
+qux/xy qux/xy.o
+__OUT__
+
 test_oE '* does not match initial dot'
 echo baz/*dir/*file
 __IN__
@@ -48,6 +48,8 @@ mkdir markdirs
 cd markdirs
 >regular
 mkdir directory
+ln -s directory symlink
+ln -s no_such_file dangling
 )
 
 (
@@ -65,6 +67,12 @@ __IN__
 directory regular
 __OUT__
 
+test_oE 'markdirs on: symbolic links' --markdirs
+echo *n*
+__IN__
+dangling symlink/
+__OUT__
+
 )
 
 (
@@ -94,6 +102,24 @@ anotherdir/file anotherdir/loop/dir/file dir/dir/file dir/dir/link/file
 anotherdir/file dir/dir/file
 __OUT__
 
+test_oE 'parallelglob on: same results as sequential search' \
+    --extendedglob --parallelglob
+echo **/file
+echo ***/file
+echo .**/file
+echo .***/file
+echo **/**/f*e
+YASH_GLOB_THREADS=0
+echo ***/file
+__IN__
+anotherdir/file dir/dir/file
+anotherdir/file anotherdir/loop/dir/file dir/dir/file dir/dir/link/file
+.dir/dir/file .dir/file anotherdir/file dir/.dir/file dir/dir/file
+.dir/dir/file .dir/file anotherdir/file anotherdir/loop/.dir/file anotherdir/loop/dir/file dir/.dir/file dir/dir/.link/file dir/dir/file dir/dir/link/file
+anotherdir/file dir/dir/file
+anotherdir/file anotherdir/loop/dir/file dir/dir/file dir/dir/link/file
+__OUT__
+
 test_oE 'extendedglob off: effect' --noextendedglob
 echo **/file
 echo ***/file
@@ -569,6 +595,29 @@ __OUT__
 
 )
 
+test_o 'cached directory listing is updated in interactive shell' -i +m
+mkdir dircache
+>dircache/a
+touch -t 200001010000 dircache
+echo dircache/*
+echo dircache/*
+>dircache/b
+echo dircache/*
+cd dircache
+echo *
+mkdir ../dircache2
+>../dircache2/c
+touch -t 200001010000 ../dircache2
+cd ../dircache2
+echo *
+__IN__
+dircache/a
+dircache/a
+dircache/a dircache/b
+a b
+c
+__OUT__
+
 mkdir nullglob
 >nullglob/xxx
 
@@ -46,4 +46,241 @@ syntax error: ksh-like extended glob pattern `!(...)' is not supported
 __ERR__
 #`
 
+test_oE 'last command of pipeline in current shell (lastpipe)' -o lastpipe
+i=0
+printf '%s\n' 1 2 3 | while read -r x; do i=$((i+x)); done
+echo $i
+echo foo | read -r v
+echo $v
+__IN__
+6
+foo
+__OUT__
+
+test_oE 'standard input is restored after pipeline (lastpipe)' -o lastpipe
+{
+    echo foo | cat
+    read -r v
+    echo $v
+} <<\END
+bar
+END
+__IN__
+foo
+bar
+__OUT__
+
+test_oE 'exit status of pipeline (lastpipe)' -o lastpipe
+true | false
+echo $?
+false | true
+echo $?
+(exit 3) | true
+echo $?
+set -o pipefail
+(exit 3) | (exit 4) | true
+echo $?
+__IN__
+1
+0
+0
+4
+__OUT__
+
+test_oE 'pipelines nested in last command (lastpipe)' -o lastpipe
+printf '%s\n' 1 4 | {
+    read -r x
+    echo 2 | while read -r y; do z=$x$y; done
+    echo 3 | cat
+    read -r w
+    echo $w
+}
+echo $z
+__IN__
+3
+4
+12
+__OUT__
+
+test_OE -e 5 'last command can exit the shell (lastpipe)' -o lastpipe
+echo foo | { read -r v; exit 5; }
+echo not reached
+__IN__
+
+test_oE 'YASH_PIPE_SIZE does not affect pipeline contents'
+YASH_PIPE_SIZE=1048576
+printf '%s\n' foo bar | cat | tail -n 1
+YASH_PIPE_SIZE=-1
+echo baz | cat
+YASH_PIPE_SIZE=invalid
+echo qux | cat
+__IN__
+bar
+baz
+qux
+__OUT__
+
+test_oE 'time keyword prints time with TIMEFORMAT'
+TIMEFORMAT='[%%][%x]'
+{ time echo foo | cat; } 2>&1
+__IN__
+foo
+[%][%x]
+__OUT__
+
+test_oE 'time keyword output is not affected by redirection of pipeline'
+exec 2>&1
+TIMEFORMAT='timed'
+time echo foo 2>/dev/null
+{ time echo bar >/dev/null; } 2>/dev/null
+__IN__
+foo
+timed
+__OUT__
+
+test_oE 'format of time keyword output'
+TIMEFORMAT='%R %0U %1lS %P %M %w %c'
+{ time sleep 0; } 2>&1 |
+sed 's/^[0-9]*\.[0-9][0-9][0-9] [0-9]* [0-9]*m[0-9]*\.[0-9]s [0-9.]* [0-9]* [0-9]* [0-9]*$/ok/'
+__IN__
+ok
+__OUT__
+
+test_oE 'time -p output format'
+{ time -p sleep 0; } 2>&1 | sed 's/[0-9][0-9]*\.[0-9][0-9]$/N/'
+__IN__
+real N
+user N
+sys N
+__OUT__
+
+test_oE 'empty TIMEFORMAT'
+TIMEFORMAT=
+{ time echo foo; } 2>&1
+__IN__
+foo
+__OUT__
+
+test_oE 'exit status of timed pipeline'
+TIMEFORMAT=
+time false | true
+echo $?
+time true | false
+echo $?
+time ! true
+echo $?
+! time true
+echo $?
+__IN__
+0
+1
+1
+1
+__OUT__
+
+test_O -d -e 127 'time is not keyword (POSIX)' --posix
+PATH=
+time true
+__IN__
+
+test_oE 'coprocess serves multiple requests'
+coproc while read -r x; do echo "$((x * 2))"; done
+for i in 1 2 3; do
+    echo "$i" >&"${COPROC[2]}"
+    read -r y <&"${COPROC[1]}"
+    echo "$y"
+done
+eval "exec ${COPROC[2]}>&-"
+wait "$COPROC_PID"
+echo $?
+__IN__
+2
+4
+6
+0
+__OUT__
+
+test_oE 'coprocess with pipeline'
+coproc sed 's/a/A/' | tr b B
+echo abc >&"${COPROC[2]}"
+eval "exec ${COPROC[2]}>&-"
+cat <&"${COPROC[1]}"
+__IN__
+ABc
+__OUT__
+
+test_oE 'exit status of coprocess'
+coproc exit 3
+echo $?
+wait "$COPROC_PID"
+echo $?
+coproc ! false
+wait $!
+echo $?
+__IN__
+0
+3
+0
+__OUT__
+
+test_oE 'coprocess is a job'
+coproc cat
+[ "$!" = "$COPROC_PID" ] && echo pid ok
+jobs
+eval "exec ${COPROC[2]}>&-"
+wait
+__IN__
+pid ok
+[1] + Running              coproc cat
+__OUT__
+
+test_oE 'coprocess file descriptors are not inherited'
+coproc cat
+ls /dev/fd/ | grep -Fqx "${COPROC[1]}" || echo not inherited
+eval "exec ${COPROC[2]}>&-"
+wait
+__IN__
+not inherited
+__OUT__
+
+test_oE 'new coprocess closes pipes to previous coprocess'
+coproc cat
+pid=$COPROC_PID
+echo foo >&"${COPROC[2]}"
+read -r x <&"${COPROC[1]}"
+echo "$x"
+coproc cat
+wait "$pid"
+echo $?
+echo bar >&"${COPROC[2]}"
+read -r x <&"${COPROC[1]}"
+echo "$x"
+eval "exec ${COPROC[2]}>&-"
+wait
+__IN__
+foo
+0
+bar
+__OUT__
+
+test_oE 'reused file descriptor of previous coprocess is not closed'
+coproc cat
+eval "exec ${COPROC[1]}<&- ${COPROC[2]}>&-"
+wait
+echo data >file
+eval "exec ${COPROC[1]}<file"
+fd=${COPROC[1]}
+coproc cat
+eval "exec ${COPROC[2]}>&-"
+wait
+eval "cat <&$fd"
+__IN__
+data
+__OUT__
+
+test_O -d -e 127 'coproc is not keyword (POSIX)' --posix
+PATH=
+coproc true
+__IN__
+
 # vim: set ft=sh ts=8 sts=4 sw=4 noet:
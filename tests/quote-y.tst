@@ -205,4 +205,52 @@ __ERR__
 #`
 #"
 
+(
+setup -d
+
+test_oE 'literal word and its quoted equivalents'
+bracket --verbose --ver\bose --ver'b'ose --ver"bo"se
+__IN__
+[--verbose][--verbose][--verbose][--verbose]
+__OUT__
+
+test_oE 'literal word with brace' -o braceexpand
+bracket a{b a{b,c} a{1..3}
+__IN__
+[a{b][ab][ac][a1][a2][a3]
+__OUT__
+
+test_oE 'literal word with tilde'
+HOME=/home
+bracket ~_no_such_user_/ ~ ~/a x~ a=~
+__IN__
+[~_no_such_user_/][/home][/home/a][x~][a=~]
+__OUT__
+
+test_oE 'quote removal of mixed quotes and backslashes'
+bracket \a\b\c "a\b\"c" 'a\"b' a"b"'c'\d "" ''"" \\\\ "\\\\"
+__IN__
+[abc][a\b"c][a\"b][abcd][][][\\][\\]
+__OUT__
+
+test_oE 'quoted pattern characters are not expanded'
+>'a*b' >ab
+v='a*'
+bracket a\*b a"*"b a'*'b a*b
+bracket "$v" x"$v" $v
+__IN__
+[a*b][a*b][a*b][a*b][ab]
+[a*][xa*][a*b][ab]
+__OUT__
+
+test_oE 'pattern characters from tilde expansion are not expanded'
+>a
+HOME='*'
+bracket ~ ~/
+__IN__
+[*][*/]
+__OUT__
+
+)
+
 # vim: set ft=sh ts=8 sts=4 sw=4 noet:
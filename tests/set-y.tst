@@ -201,10 +201,12 @@ test_long_option_default_off "$LINENO" extendedglob
 test_long_option_default_on  "$LINENO" glob
 test_long_option_default_off "$LINENO" hashondef
 test_long_option_default_off "$LINENO" ignoreeof
+test_long_option_default_off "$LINENO" lastpipe
 test_long_option_default_off "$LINENO" markdirs
 # The monitor option cannot be tested here due to dependency on the terminal.
 test_long_option_default_off "$LINENO" notify
 test_long_option_default_off "$LINENO" nullglob
+test_long_option_default_off "$LINENO" parallelglob
 test_long_option_default_off "$LINENO" pipefail
 # This needs a special test (see below)
 #test_long_option_default_off "$LINENO" posixlycorrect
@@ -411,17 +413,20 @@ errexit         off
 errreturn       off
 exec            on
 extendedglob    off
+forlazyglob     off
 forlocal        on
 glob            on
 hashondef       off
 ignoreeof       off
 interactive     off
+lastpipe        off
 log             on
 login           off
 markdirs        off
 monitor         off
 notify          off
 nullglob        off
+parallelglob    off
 pipefail        off
 posixlycorrect  off
 stdin           on
@@ -466,15 +471,18 @@ set +o errexit
 set +o errreturn
 set -o exec
 set +o extendedglob
+set +o forlazyglob
 set -o forlocal
 set -o glob
 set +o hashondef
 set +o ignoreeof
+set +o lastpipe
 set -o log
 set +o markdirs
 set +o monitor
 set +o notify
 set +o nullglob
+set +o parallelglob
 set +o pipefail
 set +o posixlycorrect
 set -o traceall
@@ -128,4 +128,41 @@ __IN__
 
 )
 
+test_oE 'external command without shebang is run by shell'
+echo 'echo "$0" "$@"' >script
+chmod a+x script
+./script a b
+__IN__
+./script a b
+__OUT__
+
+test_oE 'signal dispositions of external command'
+trap '' USR1
+trap 'echo trapped' USR2
+sh -c 'kill -s USR1 $$; echo not killed'
+sh -c 'kill -s USR2 $$; echo not reached'
+kill -l $?
+__IN__
+not killed
+USR2
+__OUT__
+
+(
+if ! [ -r /proc/self/status ]; then
+    skip="true"
+fi
+
+test_oE 'ignored SIGCHLD is inherited by external command'
+(
+trap '' CHLD
+a="$("$TESTEE" -c 'grep SigIgn /proc/self/status; :')"
+b="$("$TESTEE" -c 'exec grep SigIgn /proc/self/status')"
+[ "$a" = "$b" ] && echo same
+)
+__IN__
+same
+__OUT__
+
+)
+
 # vim: set ft=sh ts=8 sts=4 sw=4 noet:
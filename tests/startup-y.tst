@@ -553,12 +553,14 @@ Options:
 	         -o errreturn
 	+n       -o exec
 	         -o extendedglob
+	         -o forlazyglob
 	         -o forlocal
 	+f       -o glob
 	-h       -o hashondef
 	         -o histspace
 	         -o ignoreeof
 	-i       -o interactive
+	         -o lastpipe
 	         -o lealwaysrp
 	         -o lecompdebug
 	         -o leconvmeta
@@ -574,6 +576,7 @@ Options:
 	-b       -o notify
 	         -o notifyle
 	         -o nullglob
+	         -o parallelglob
 	         -o pipefail
 	         -o posixlycorrect
 	-s       -o stdin
@@ -611,12 +614,14 @@ Options:
 	         -o errreturn
 	+n       -o exec
 	         -o extendedglob
+	         -o forlazyglob
 	         -o forlocal
 	+f       -o glob
 	-h       -o hashondef
 	         -o histspace
 	         -o ignoreeof
 	-i       -o interactive
+	         -o lastpipe
 	         -o lealwaysrp
 	         -o lecompdebug
 	         -o leconvmeta
@@ -632,6 +637,7 @@ Options:
 	-b       -o notify
 	         -o notifyle
 	         -o nullglob
+	         -o parallelglob
 	         -o pipefail
 	         -o posixlycorrect
 	-s       -o stdin
@@ -147,6 +147,36 @@ __IN__
 reached
 __OUT__
 
+test_oE 'trap can reset itself during execution'
+trap 'trap - USR1; echo trapped' USR1
+kill -s USR1 $$
+trap -p USR1
+echo reached
+__IN__
+trapped
+reached
+__OUT__
+
+test_oE 'alias defined after trap is set is substituted in trap'
+trap 'foo' USR1
+alias foo='echo aliased'
+kill -s USR1 $$
+unalias foo
+foo() { echo function; }
+kill -s USR1 $$
+__IN__
+aliased
+function
+__OUT__
+
+test_oE 'alias defined in trap affects following lines of trap'
+trap 'alias foo="echo aliased"
+foo' USR1
+kill -s USR1 $$
+__IN__
+aliased
+__OUT__
+
 test_Oe -e 1 'setting trap for KILL'
 trap '' KILL
 __IN__
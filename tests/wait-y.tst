@@ -66,6 +66,69 @@ wait
 wait $pid
 __IN__
 
+test_oE 'wait -n returns on first finished job'
+(cat sync; exit 1) &
+(exit 2) &
+wait -n
+echo $?
+>sync
+wait -n
+echo $?
+__IN__
+2
+1
+__OUT__
+
+test_oE 'wait -n with operands'
+(exit 4) &
+a=$!
+(cat sync; exit 5) &
+b=$!
+wait -n $a
+echo $?
+>sync
+wait -n $b %
+echo $?
+__IN__
+4
+5
+__OUT__
+
+test_oE 'wait -n assigns process ID of awaited job to variable'
+(exit 6) &
+pid=$!
+wait -n -p var
+echo $? $((var == pid))
+__IN__
+6 1
+__OUT__
+
+test_x -e 127 'wait -n without jobs'
+wait -n
+__IN__
+
+test_x -e 127 'wait -n with non-existing job'
+wait -n %100
+__IN__
+
+test_Oe -e 1 'wait -p with invalid variable name'
+wait -n -p a=b
+__IN__
+wait: `a=b' is not a valid variable name
+__ERR__
+#'
+#`
+
+test_oE 'YASH_JOB_SLOTS limits number of running jobs'
+YASH_JOB_SLOTS=1
+(sleep 1; echo 1) &
+echo 2 &
+wait
+__IN__
+1
+2
+__OUT__
+
 test_Oe -e 2 'invalid option --xxx'
 wait --no-such=option
 __IN__
@@ -74,4 +137,28 @@ __ERR__
 #'
 #`
 
+test_oE 'waiting for process ID of job'
+(exit 3) & a=$!
+(exit 4) & b=$!
+wait $b; echo $?
+wait $a; echo $?
+sleep 0 | (exit 6) & c=$!
+wait $c; echo $?
+__IN__
+4
+3
+6
+__OUT__
+
+test_oE 'disowned job is not awaited'
+sleep 10 & p=$!
+disown
+wait; echo $?
+wait $p; echo $?
+kill $p
+__IN__
+0
+127
+__OUT__
+
 # vim: set ft=sh ts=8 sts=4 sw=4 noet:
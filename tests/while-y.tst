@@ -152,4 +152,41 @@ __ERR__
 
 # `do' and `done' without `while` are tested in for-y.tst.
 
+test_oE 'trap set in loop without traps or jobs is run promptly'
+i=0
+while [ $i -lt 5 ]; do
+    i=$((i+1))
+    if [ $i -eq 2 ]; then trap 'echo trapped at $i' USR1; fi
+    if [ $i -eq 3 ]; then kill -s USR1 $$; echo after kill at $i; fi
+done
+__IN__
+trapped at 3
+after kill at 3
+__OUT__
+
+test_oE 'job started after loop without traps or jobs is reaped without wait'
+i=0
+while [ $i -lt 10 ]; do i=$((i+1)); sh -c :; done
+: &
+while kill -0 $! 2>/dev/null; do :; done
+echo reaped
+jobs
+__IN__
+reaped
+[1] + Done                 :
+__OUT__
+
+test_oE 'trap set after all jobs are removed is run promptly'
+: &
+wait
+i=0
+while [ $i -lt 10 ]; do i=$((i+1)); done
+trap 'echo trapped' USR1
+kill -s USR1 $$
+echo end
+__IN__
+trapped
+end
+__OUT__
+
 # vim: set ft=sh ts=8 sts=4 sw=4 noet:
@@ -25,6 +25,7 @@
 # include <libintl.h>
 #endif
 #include <limits.h>
+#include <locale.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -34,6 +35,7 @@
 #include "exec.h"
 #include "option.h"
 #include "plist.h"
+#include "strbuf.h"
 
 
 /********** Memory Utilities **********/
@@ -221,6 +223,93 @@ void *copyaswcs(const void *p)
     return xwcsdup(p);
 }
 
+/* An element of the array sorted in `sort_by_wcscoll' */
+struct collitem_T {
+    const wchar_t *key;
+    size_t index;
+};
+
+static bool collation_is_codepoint(void);
+static int collitem_cmp(const void *p1, const void *p2)
+    __attribute__((pure,nonnull));
+
+/* Sorts array `base' of `count' elements, each `size' bytes long, in the
+ * collation order of the wide strings `getkey' returns for the elements.
+ * The result is the same as that of `qsort' with a comparison function that
+ * uses `wcscoll', but the collation key of each element is computed only once
+ * rather than in every comparison. If the locale collates strings by character
+ * values, the strings are compared directly without computing keys.
+ * Elements with equal keys keep their original order. */
+void sort_by_wcscoll(void *base, size_t count, size_t size,
+	const wchar_t *getkey(const void *elem))
+{
+    if (count < 2)
+	return;
+
+    char *array = base;
+    struct collitem_T *items = xmallocn(count, sizeof *items);
+    xwcsbuf_T keys;
+    wb_init(&keys);
+    if (collation_is_codepoint()) {
+	for (size_t i = 0; i < count; i++)
+	    items[i].key = getkey(&array[i * size]);
+    } else {
+	/* The keys are stored in a single buffer, separated by null characters.
+	 * As the buffer may be reallocated, the offsets to the keys are
+	 * recorded first and converted to pointers afterwards. */
+	for (size_t i = 0; i < count; i++) {
+	    items[i].index = keys.length;
+	    wb_wcsxfrmcat(&keys, getkey(&array[i * size]));
+	    wb_wccat(&keys, L'\0');
+	}
+	for (size_t i = 0; i < count; i++)
+	    items[i].key = &keys.contents[items[i].index];
+    }
+
+    /* Pointers to the items are sorted rather than the items themselves
+     * because `qsort' is usually fastest for pointer-sized elements. */
+    struct collitem_T **ptrs = xmallocn(count, sizeof *ptrs);
+    for (size_t i = 0; i < count; i++) {
+	items[i].index = i;
+	ptrs[i] = &items[i];
+    }
+
+    qsort(ptrs, count, sizeof *ptrs, collitem_cmp);
+
+    char *sorted = xmallocn(count, size);
+    for (size_t i = 0; i < count; i++)
+	memcpy(&sorted[i * size], &array[ptrs[i]->index * size], size);
+    memcpy(array, sorted, count * size);
+
+    free(sorted);
+    free(ptrs);
+    wb_destroy(&keys);
+    free(items);
+}
+
+/* Returns true if the current locale collates wide strings in the order of
+ * character values, in which case `wcscoll' is equivalent to `wcscmp'.
+ * This is true for the C/POSIX locale and its variants with another codeset
+ * such as "C.UTF-8". */
+bool collation_is_codepoint(void)
+{
+    const char *locale = setlocale(LC_COLLATE, NULL);
+    return locale != NULL && (strcmp(locale, "POSIX") == 0 ||
+	    (locale[0] == 'C' && (locale[1] == '\0' || locale[1] == '.')));
+}
+
+/* Compares two (const struct collitem_T *const *)s. Items with equal keys
+ * are ordered by their original positions so that the result is stable. */
+int collitem_cmp(const void *p1, const void *p2)
+{
+    const struct collitem_T *item1 = *(const struct collitem_T *const *) p1;
+    const struct collitem_T *item2 = *(const struct collitem_T *const *) p2;
+    int result = wcscmp(item1->key, item2->key);
+    if (result != 0)
+	return result;
+    return (item1->index > item2->index) - (item1->index < item2->index);
+}
+
 
 /********** Error Utilities **********/
 
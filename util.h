@@ -209,6 +209,9 @@ extern wchar_t *matchwcsprefix(const wchar_t *s, const wchar_t *prefix)
     __attribute__((pure,nonnull));
 extern void *copyaswcs(const void *p)
     __attribute__((malloc,warn_unused_result,nonnull));
+extern void sort_by_wcscoll(void *base, size_t count, size_t size,
+	const wchar_t *getkey(const void *elem))
+    __attribute__((nonnull));
 
 #if HAVE_STRNLEN
 # ifndef strnlen
@@ -196,6 +196,10 @@ static bool random_active;
 /* hashtable from function names (wchar_t *) to functions (function_T *). */
 static hashtable_T functions;
 
+/* Incremented whenever any function is defined or unset so that results of
+ * command search can be cached. */
+unsigned long function_generation = 0;
+
 
 /* Frees the value of the specified variable (but not the variable itself). */
 /* This function does not change the value of `*v'. */
@@ -811,6 +815,13 @@ const wchar_t *getvar(const wchar_t *name)
     return NULL;
 }
 
+/* Checks if the specified variable exists and is read-only. */
+bool is_readonly_variable(const wchar_t *name)
+{
+    variable_T *var = search_variable(name);
+    return var != NULL && (var->v_type & VF_READONLY);
+}
+
 /* Returns the value(s) of the specified variable/array as an array.
  * The return value's type is `struct get_variable_T'. It has three members:
  * `type', `count' and `values'.
@@ -1259,6 +1270,7 @@ bool define_function(const wchar_t *name, command_T *body)
     if (shopt_hashondef)
 	hash_all_commands_recursively(body);
     funckvfree(ht_set(&functions, xwcsdup(name), f));
+    function_generation++;
     return true;
 }
 
@@ -1710,7 +1722,7 @@ int typeset_builtin(int argc, void **argv)
 	if (!function) {
 	    /* print all variables */
 	    count = make_array_of_all_variables(global, &kvs);
-	    qsort(kvs, count, sizeof *kvs, keywcscoll);
+	    sort_by_wcscoll(kvs, count, sizeof *kvs, keywcs);
 	    for (size_t i = 0; yash_error_message_count == 0 && i < count; i++)
 		print_variable(
 			kvs[i].key, kvs[i].value, ARGV(0), readonly, export);
@@ -1718,7 +1730,7 @@ int typeset_builtin(int argc, void **argv)
 	    /* print all functions */
 	    kvs = ht_tokvarray(&functions);
 	    count = functions.count;
-	    qsort(kvs, count, sizeof *kvs, keywcscoll);
+	    sort_by_wcscoll(kvs, count, sizeof *kvs, keywcs);
 	    for (size_t i = 0; yash_error_message_count == 0 && i < count; i++)
 		print_function(kvs[i].key, kvs[i].value, ARGV(0), readonly);
 	}
@@ -2105,7 +2117,7 @@ int array_dump_all(const wchar_t *argv0)
 {
     kvpair_T *kvs;
     size_t count = make_array_of_all_variables(true, &kvs);
-    qsort(kvs, count, sizeof *kvs, keywcscoll);
+    sort_by_wcscoll(kvs, count, sizeof *kvs, keywcs);
     for (size_t i = 0; yash_error_message_count == 0 && i < count; i++) {
 	variable_T *var = kvs[i].value;
 	if ((var->v_type & VF_MASK) == VF_ARRAY)
@@ -2337,6 +2349,7 @@ bool unset_function(const wchar_t *name)
     if (f != NULL) {
 	if (!(f->f_type & VF_NODELETE)) {
 	    funckvfree(kv);
+	    function_generation++;
 	} else {
 	    xerror(0, Ngt("function `%ls' is read-only"), name);
 	    ht_set(&functions, kv.key, kv.value);
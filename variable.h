@@ -29,6 +29,8 @@ extern char **environ;
 #define VAR_CDPATH                    "CDPATH"
 #define VAR_COLUMNS                   "COLUMNS"
 #define VAR_COMMAND_NOT_FOUND_HANDLER "COMMAND_NOT_FOUND_HANDLER"
+#define VAR_COPROC                    "COPROC"
+#define VAR_COPROC_PID                "COPROC_PID"
 #define VAR_DIRSTACK                  "DIRSTACK"
 #define VAR_ECHO_STYLE                "ECHO_STYLE"
 #define VAR_ENV                       "ENV"
@@ -66,10 +68,15 @@ extern char **environ;
 #define VAR_RANDOM                    "RANDOM"
 #define VAR_TARGETWORD                "TARGETWORD"
 #define VAR_TERM                      "TERM"
+#define VAR_TIMEFORMAT                "TIMEFORMAT"
 #define VAR_WORDS                     "WORDS"
 #define VAR_YASH_AFTER_CD             "YASH_AFTER_CD"
+#define VAR_YASH_GLOB_THREADS         "YASH_GLOB_THREADS"
+#define VAR_YASH_JOB_SLOTS            "YASH_JOB_SLOTS"
 #define VAR_YASH_LE_TIMEOUT           "YASH_LE_TIMEOUT"
 #define VAR_YASH_LOADPATH             "YASH_LOADPATH"
+#define VAR_YASH_PIPE_SIZE            "YASH_PIPE_SIZE"
+#define VAR_YASH_RUSAGE               "YASH_RUSAGE"
 #define VAR_YASH_VERSION              "YASH_VERSION"
 #define L                             L""
 
@@ -114,6 +121,8 @@ struct get_variable_T {
 };
 extern const wchar_t *getvar(const wchar_t *name)
     __attribute__((pure,nonnull));
+extern _Bool is_readonly_variable(const wchar_t *name)
+    __attribute__((pure,nonnull));
 extern struct get_variable_T get_variable(const wchar_t *name)
     __attribute__((nonnull,warn_unused_result));
 extern void save_get_variable_values(struct get_variable_T *gv)
@@ -128,6 +137,7 @@ extern char **decompose_paths(const wchar_t *paths)
     __attribute__((malloc,warn_unused_result));
 extern char *const *get_path_array(path_T name);
 
+extern unsigned long function_generation;
 extern _Bool define_function(const wchar_t *name, struct command_T *body)
     __attribute__((nonnull));
 extern struct command_T *get_function(const wchar_t *name)